@@ -164,3 +164,30 @@ plt.savefig("plots/qd_tradeoff_curve.png", dpi=150)
 tail_df = df[df['jobname'].str.startswith("tail_lat")]
 print("\nTail latency characterization:")
 print(tail_df[["jobname","iodepth","read_p50_us","read_p95_us","read_p99_us","read_p99_us"]])
+
+# -------- 6. WAL durability path --------
+if os.path.exists("results/wal_commit.csv"):
+    wal_df = pd.read_csv("results/wal_commit.csv")
+    print("\nWAL commit latency:")
+    print(wal_df)
+
+    group = wal_df[wal_df["mode"] == "group"].sort_values("batch")
+    plt.figure()
+    for col, color in [("p50_us", "blue"), ("p99_us", "red"), ("p999_us", "purple")]:
+        plt.plot(group["batch"], group[col], marker='o', color=color, label=f"group {col[:-3]}")
+    for _, row in wal_df[wal_df["mode"] != "group"].iterrows():
+        plt.axhline(row["p99_us"], linestyle="--", alpha=0.6, label=f"{row['mode']} p99")
+    plt.xscale("log", base=2)
+    plt.yscale("log")
+    plt.xlabel("Group commit batch size")
+    plt.ylabel("Commit latency (us)")
+    plt.title(f"WAL commit latency vs batch size (wait={group['wait_us'].max()} us)")
+    plt.legend(fontsize=8)
+    plt.grid(True)
+    plt.savefig("plots/wal_commit_latency.png", dpi=150)
+
+# -------- 7. Adaptive knee search --------
+if os.path.exists("results/knee_summary.csv"):
+    knee_df = pd.read_csv("results/knee_summary.csv")
+    print("\nAdaptive knee search (operating point per block size):")
+    print(knee_df)
@@ -2,21 +2,109 @@
 # ssd_profile.sh
 # Run SSD performance profiling experiments with fio
 # Usage: ./ssd_profile.sh /mnt/project_partition/testfile.img
+#        ./ssd_profile.sh --adaptive /mnt/project_partition/testfile.img
 
 set -euo pipefail
 
+ADAPTIVE=0
+if [ "${1:-}" == "--adaptive" ]; then
+    ADAPTIVE=1
+    shift
+fi
+
 if [ $# -ne 1 ]; then
-    echo "Usage: $0 <target-file>"
+    echo "Usage: $0 [--adaptive] <target-file>"
     exit 1
 fi
 
 TARGET=$1
+SCRIPT_DIR=$(dirname "$0")
 RESULTS_DIR=results/
 mkdir -p "$RESULTS_DIR"
 
 # Common fio options
 COMMON="--filename=$TARGET --direct=1 --ioengine=libaio --time_based --runtime=30s --group_reporting --output-format=json"
 
+########################################
+# Adaptive knee search (--adaptive)
+########################################
+# Bisects over QD = 1..128 for each block size instead of sweeping every point.
+# The knee is the smallest QD where doubling the depth gains less than
+# KNEE_GAIN throughput while p99 still rises. Each point runs in short slices
+# and stops as soon as two consecutive slices agree within STABLE_PCT.
+KNEE_BS=${KNEE_BS:-"4k 16k 64k"}
+KNEE_GAIN=${KNEE_GAIN:-0.05}
+SLICE=${SLICE:-5s}
+MAX_SLICES=${MAX_SLICES:-6}
+STABLE_PCT=${STABLE_PCT:-0.03}
+KNEE_QDS=(1 2 4 8 16 32 64 128)
+
+# Prints "iops p99_us" for one fio JSON result
+fio_point() {
+    python3 - "$1" <<'EOF'
+import json, sys
+job = json.load(open(sys.argv[1]))["jobs"][0]
+rd = job["read"]
+print(rd["iops"], rd["clat_ns"]["percentile"]["99.000000"] / 1000)
+EOF
+}
+
+declare -A KNEE_IOPS KNEE_P99
+
+# Runs one (bs, qd) point until its IOPS stabilize, caching the result
+measure_point() {
+    local bs=$1 qd=$2 key="$1_$2"
+    [[ -n "${KNEE_IOPS[$key]:-}" ]] && return
+    local prev="" iops p99 slice
+    for ((slice = 1; slice <= MAX_SLICES; slice++)); do
+        local out="$RESULTS_DIR/knee/knee_${bs}_qd${qd}_s${slice}.json"
+        fio ${COMMON/--runtime=30s/--runtime=$SLICE} --name=knee_${bs}_qd${qd} --rw=randread --bs=$bs \
+            --iodepth=$qd --numjobs=1 --lat_percentiles=1 --output="$out"
+        read -r iops p99 < <(fio_point "$out")
+        if [[ -n "$prev" ]] && awk -v a="$iops" -v b="$prev" -v t="$STABLE_PCT" \
+                'BEGIN { d = (a - b) / b; exit !((d < 0 ? -d : d) < t) }'; then
+            break
+        fi
+        prev=$iops
+    done
+    KNEE_IOPS[$key]=$iops
+    KNEE_P99[$key]=$p99
+    echo "  bs=$bs qd=$qd iops=$iops p99=${p99}us (slices=$((slice > MAX_SLICES ? MAX_SLICES : slice)))"
+}
+
+# True if doubling the QD past KNEE_QDS[$2] no longer pays off
+past_knee() {
+    local bs=$1 lo=${KNEE_QDS[$2]} hi=${KNEE_QDS[$2 + 1]}
+    measure_point "$bs" "$lo"
+    measure_point "$bs" "$hi"
+    awk -v i0="${KNEE_IOPS[${bs}_$lo]}" -v i1="${KNEE_IOPS[${bs}_$hi]}" \
+        -v p0="${KNEE_P99[${bs}_$lo]}" -v p1="${KNEE_P99[${bs}_$hi]}" -v g="$KNEE_GAIN" \
+        'BEGIN { exit !((i1 / i0 - 1) < g && p1 > p0) }'
+}
+
+if [ "$ADAPTIVE" -eq 1 ]; then
+    echo "Running adaptive knee search..."
+    mkdir -p "$RESULTS_DIR/knee"
+    summary="$RESULTS_DIR/knee_summary.csv"
+    echo "bs,knee_qd,iops,p99_us,points_measured" > "$summary"
+    for bs in $KNEE_BS; do
+        lo=0
+        hi=$((${#KNEE_QDS[@]} - 1))
+        while [ $lo -lt $hi ]; do
+            mid=$(((lo + hi) / 2))
+            if past_knee "$bs" $mid; then hi=$mid; else lo=$((mid + 1)); fi
+        done
+        qd=${KNEE_QDS[$lo]}
+        measure_point "$bs" "$qd"
+        points=0
+        for key in "${!KNEE_IOPS[@]}"; do [[ $key == ${bs}_* ]] && points=$((points + 1)); done
+        echo "$bs,$qd,${KNEE_IOPS[${bs}_$qd]},${KNEE_P99[${bs}_$qd]},$points" >> "$summary"
+        echo "Knee for bs=$bs: QD=$qd"
+    done
+    echo "Adaptive search done. Operating points stored in $summary"
+    exit 0
+fi
+
 ########################################
 # 1. Zero-queue baselines (QD=1)
 ########################################
@@ -61,10 +149,21 @@ done
 # 5. Tail latency characterization
 ########################################
 echo "Running tail latency characterization..."
-# Example: mid-QD=16, near-knee QD=64 (adjust if your SSD knee differs)
+# Example: mid-QD=16, near-knee QD=64 (adjust if your SSD knee differs;
+# ./ssd_profile.sh --adaptive reports the knee per block size)
 for qd in 16 64; do
     fio $COMMON --name=tail_lat_qd${qd} --rw=randread --bs=4k --iodepth=$qd --numjobs=1 \
         --output="$RESULTS_DIR/tail_lat_qd${qd}.json" --lat_percentiles=1
 done
 
+########################################
+# 6. Durability path (WAL commit latency)
+########################################
+echo "Running WAL durability sweep..."
+# Per-write fsync / fdatasync / O_DSYNC, then group commit at batch 1..writers.
+# The log file lives next to the target and is preconditioned by wal_bench.
+gcc -O2 -pthread "$SCRIPT_DIR/wal_bench.c" -o "$SCRIPT_DIR/wal_bench"
+"$SCRIPT_DIR/wal_bench" "$(dirname "$TARGET")/wal_test.dat" "${WAL_SIZE_MB:-1024}" "${WAL_WAIT_US:-200}" \
+    "${WAL_WRITERS:-64}" > "$RESULTS_DIR/wal_commit.csv"
+
 echo "All experiments done. Results stored in $RESULTS_DIR/"
\ No newline at end of file
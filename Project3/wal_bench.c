@@ -0,0 +1,195 @@
+// wal_bench.c
+// Write-ahead-log durability benchmark: commit latency for per-write fsync,
+// fdatasync, O_DSYNC and batched group commit.
+// Usage: ./wal_bench <log-file> [size_MB] [wait_us] [writers]
+// Prints CSV to stdout: one row per (mode, batch size).
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RECORD 4096          // bytes appended per commit
+#define PRECOND_PASSES 2     // full sequential overwrites before measuring
+#define RUN_SEC 5.0          // measurement time per configuration
+
+enum mode { M_FSYNC, M_FDATASYNC, M_ODSYNC, M_GROUP };
+static const char* mode_names[] = {"fsync", "fdatasync", "odsync", "group"};
+
+typedef struct { double* v; size_t n, cap; } lat_vec;
+
+static const char* path;
+static long file_size, n_records;
+static int fd, writers;
+static enum mode mode;
+static long batch, wait_us;
+
+static pthread_mutex_t log_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pending_cv, flushed_cv;
+static long appended, flushed;          // record sequence numbers, guarded by log_mu
+static volatile int stop_writers, stop_flusher;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void lat_push(lat_vec* l, double x) {
+    if (l->n == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 4096;
+        l->v = realloc(l->v, l->cap * sizeof(double));
+    }
+    l->v[l->n++] = x;
+}
+
+int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Bring the log file to steady state: fully allocated and overwritten, so
+// appends during the run never extend the file or touch fresh flash blocks.
+void precondition() {
+    int pfd = open(path, O_CREAT | O_WRONLY, 0644);
+    if (pfd < 0) { perror("open"); exit(1); }
+    size_t chunk = 1 << 20;
+    char* buf = malloc(chunk);
+    srand(42);
+    for (size_t i = 0; i < chunk; i++) buf[i] = rand();
+    for (int pass = 0; pass < PRECOND_PASSES; pass++) {
+        fprintf(stderr, "preconditioning pass %d/%d\n", pass + 1, PRECOND_PASSES);
+        for (long off = 0; off < file_size; off += chunk)
+            if (pwrite(pfd, buf, chunk, off) != (ssize_t)chunk) { perror("pwrite"); exit(1); }
+        fsync(pfd);
+    }
+    free(buf);
+    close(pfd);
+}
+
+// Group-commit flusher: waits for the first pending record, then until either
+// `batch` records are pending or `wait_us` has passed, and syncs them together.
+void* flusher(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&log_mu);
+    while (!stop_flusher) {
+        while (appended == flushed && !stop_flusher)
+            pthread_cond_wait(&pending_cv, &log_mu);
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += wait_us * 1000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        while (appended - flushed < batch && !stop_flusher)
+            if (pthread_cond_timedwait(&pending_cv, &log_mu, &deadline) == ETIMEDOUT) break;
+        long target = appended;
+        pthread_mutex_unlock(&log_mu);
+        fdatasync(fd);
+        pthread_mutex_lock(&log_mu);
+        flushed = target;
+        pthread_cond_broadcast(&flushed_cv);
+    }
+    pthread_mutex_unlock(&log_mu);
+    return NULL;
+}
+
+// One client: append a record, return once it is durable, record the latency
+void* writer(void* arg) {
+    lat_vec* lat = arg;
+    char buf[RECORD];
+    memset(buf, 'W', sizeof(buf));
+    while (!stop_writers) {
+        double t0 = now_sec();
+        pthread_mutex_lock(&log_mu);
+        long seq = ++appended;
+        if (pwrite(fd, buf, RECORD, (seq % n_records) * RECORD) != RECORD) { perror("pwrite"); exit(1); }
+        if (mode == M_FSYNC) fsync(fd);
+        else if (mode == M_FDATASYNC) fdatasync(fd);
+        else if (mode == M_GROUP) {
+            long pending = appended - flushed;
+            if (pending == 1 || pending >= batch) pthread_cond_signal(&pending_cv);
+            while (flushed < seq) pthread_cond_wait(&flushed_cv, &log_mu);
+        }
+        // M_ODSYNC: the pwrite itself returns only once the data is durable
+        if (mode != M_GROUP) flushed = seq;
+        pthread_mutex_unlock(&log_mu);
+        lat_push(lat, (now_sec() - t0) * 1e6);
+    }
+    return NULL;
+}
+
+void run(enum mode m, long b) {
+    mode = m;
+    batch = b;
+    appended = flushed = 0;
+    stop_writers = stop_flusher = 0;
+    fd = open(path, O_WRONLY | (m == M_ODSYNC ? O_DSYNC : 0));
+    if (fd < 0) { perror("open"); exit(1); }
+
+    pthread_t fl, th[writers];
+    lat_vec lats[writers];
+    memset(lats, 0, sizeof(lats));
+    if (m == M_GROUP) pthread_create(&fl, NULL, flusher, NULL);
+
+    double t0 = now_sec();
+    for (int i = 0; i < writers; i++) pthread_create(&th[i], NULL, writer, &lats[i]);
+    usleep(RUN_SEC * 1e6);
+    stop_writers = 1;
+    for (int i = 0; i < writers; i++) pthread_join(th[i], NULL);
+    double elapsed = now_sec() - t0;
+    if (m == M_GROUP) {
+        pthread_mutex_lock(&log_mu);
+        stop_flusher = 1;
+        pthread_cond_signal(&pending_cv);
+        pthread_mutex_unlock(&log_mu);
+        pthread_join(fl, NULL);
+    }
+    close(fd);
+
+    lat_vec all = {0};
+    for (int i = 0; i < writers; i++) {
+        for (size_t j = 0; j < lats[i].n; j++) lat_push(&all, lats[i].v[j]);
+        free(lats[i].v);
+    }
+    qsort(all.v, all.n, sizeof(double), cmp_double);
+    double pct[] = {0.50, 0.95, 0.99, 0.999};
+    printf("%s,%ld,%ld,%d,%.1f", mode_names[m], b, m == M_GROUP ? wait_us : 0, writers, all.n / elapsed);
+    for (int i = 0; i < 4; i++)
+        printf(",%.1f", all.n ? all.v[(size_t)(pct[i] * (all.n - 1))] : 0.0);
+    printf("\n");
+    fflush(stdout);
+    free(all.v);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <log-file> [size_MB] [wait_us] [writers]\n", argv[0]);
+        return 1;
+    }
+    path = argv[1];
+    file_size = (argc > 2 ? atol(argv[2]) : 1024) << 20;
+    wait_us = argc > 3 ? atol(argv[3]) : 200;
+    writers = argc > 4 ? atoi(argv[4]) : 64;
+    n_records = file_size / RECORD;
+
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&pending_cv, &ca);
+    pthread_cond_init(&flushed_cv, NULL);
+
+    precondition();
+
+    printf("mode,batch,wait_us,writers,commits_per_s,p50_us,p95_us,p99_us,p999_us\n");
+    run(M_FSYNC, 1);
+    run(M_FDATASYNC, 1);
+    run(M_ODSYNC, 1);
+    for (long b = 1; b <= writers; b *= 2)
+        run(M_GROUP, b);
+    return 0;
+}
@@ -7,10 +7,23 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/aio_abi.h>
+#include <linux/io_uring.h>
 
 
 #define FILE_SIZE (100 * 1024 * 1024)
 #define BLOCK 4096
+#define NBLK (FILE_SIZE / BLOCK)
+#define MAX_QD 64
+
+// Cache state each backend is measured under
+enum cache_mode { CACHE_HOT, CACHE_COLD, CACHE_DIRECT };
+static const char* cache_names[] = {"hot", "cold", "direct"};
+
+static off_t offs[NBLK]; // shuffled block offsets, same order for every backend
+static char* ring;       // MAX_QD * BLOCK buffer ring, page aligned for O_DIRECT
 
 double now_sec(){struct timespec ts;clock_gettime(CLOCK_MONOTONIC,&ts);return ts.tv_sec+ts.tv_nsec/1e9;}
 
@@ -21,31 +34,202 @@ void make_file(const char* f){
     close(fd);
 }
 
+// Evict the file from the page cache (system-wide drop too, when running as root)
+void drop_cache(int fd){
+    fdatasync(fd);
+    posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED);
+    int dc=open("/proc/sys/vm/drop_caches",O_WRONLY);
+    if(dc>=0){ sync(); write(dc,"1",1); close(dc); }
+}
+
+int open_mode(const char* f, enum cache_mode c){
+    int fd=open(f,O_RDONLY|(c==CACHE_DIRECT?O_DIRECT:0));
+    if(fd<0){ perror("open"); exit(1); }
+    if(c==CACHE_HOT){ for(off_t off=0; off<FILE_SIZE; off+=BLOCK) pread(fd,ring,BLOCK,off); }
+    else drop_cache(fd);
+    return fd;
+}
+
+// -------------------------------
+// Synchronous baseline: one pread at a time
+// -------------------------------
+double run_sync(int fd, int qd){
+    double t0=now_sec();
+    for(size_t i=0;i<NBLK;i++)
+        if(pread(fd,ring,BLOCK,offs[i])!=BLOCK) return -1;
+    return now_sec()-t0;
+}
+
+// -------------------------------
+// POSIX AIO: qd aiocbs in flight, refilled as aio_suspend reports completions
+// -------------------------------
+double run_posix_aio(int fd, int qd){
+    struct aiocb cbs[MAX_QD]; const struct aiocb* list[MAX_QD];
+    memset(cbs,0,sizeof(cbs));
+    size_t next=0, done=0;
+    double t0=now_sec();
+    for(int s=0;s<qd;s++){
+        cbs[s].aio_fildes=fd; cbs[s].aio_buf=ring+s*BLOCK; cbs[s].aio_nbytes=BLOCK;
+        cbs[s].aio_offset=offs[next++];
+        if(aio_read(&cbs[s])) return -1;
+        list[s]=&cbs[s];
+    }
+    while(done<NBLK){
+        aio_suspend(list,qd,NULL);
+        for(int s=0;s<qd;s++){
+            if(!list[s] || aio_error(&cbs[s])==EINPROGRESS) continue;
+            if(aio_return(&cbs[s])!=BLOCK) return -1;
+            done++;
+            if(next<NBLK){
+                cbs[s].aio_offset=offs[next++];
+                if(aio_read(&cbs[s])) return -1;
+            } else list[s]=NULL;
+        }
+    }
+    return now_sec()-t0;
+}
+
+// -------------------------------
+// Linux native AIO (libaio ABI): completions are refilled and resubmitted
+// with a single io_submit per io_getevents batch
+// -------------------------------
+double run_libaio(int fd, int qd){
+    aio_context_t ctx=0;
+    if(syscall(SYS_io_setup,qd,&ctx)<0) return -1;
+    struct iocb cbs[MAX_QD], *batch[MAX_QD];
+    struct io_event ev[MAX_QD];
+    memset(cbs,0,sizeof(cbs));
+    size_t next=0, done=0;
+    double t0=now_sec();
+    for(int s=0;s<qd;s++){
+        cbs[s].aio_fildes=fd; cbs[s].aio_lio_opcode=IOCB_CMD_PREAD; cbs[s].aio_data=s;
+        cbs[s].aio_buf=(__u64)(ring+s*BLOCK); cbs[s].aio_nbytes=BLOCK;
+        cbs[s].aio_offset=offs[next++];
+        batch[s]=&cbs[s];
+    }
+    if(syscall(SYS_io_submit,ctx,qd,batch)!=qd){ syscall(SYS_io_destroy,ctx); return -1; }
+    while(done<NBLK){
+        int n=syscall(SYS_io_getevents,ctx,1,qd,ev,NULL), nb=0;
+        if(n<0){ syscall(SYS_io_destroy,ctx); return -1; }
+        for(int i=0;i<n;i++){
+            if(ev[i].res!=BLOCK){ syscall(SYS_io_destroy,ctx); return -1; }
+            done++;
+            if(next<NBLK){
+                struct iocb* cb=&cbs[ev[i].data];
+                cb->aio_offset=offs[next++];
+                batch[nb++]=cb;
+            }
+        }
+        if(nb && syscall(SYS_io_submit,ctx,nb,batch)!=nb){ syscall(SYS_io_destroy,ctx); return -1; }
+    }
+    double t=now_sec()-t0;
+    syscall(SYS_io_destroy,ctx);
+    return t;
+}
+
+// -------------------------------
+// io_uring: raw rings, one io_uring_enter per reap-and-refill round
+// -------------------------------
+struct uring {
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array, *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_sz, cq_sz, sqes_sz;
+};
+
+int uring_init(struct uring* u, unsigned entries){
+    struct io_uring_params p; memset(&p,0,sizeof(p));
+    u->fd=syscall(__NR_io_uring_setup,entries,&p);
+    if(u->fd<0) return -1;
+    u->sq_sz=p.sq_off.array+p.sq_entries*sizeof(unsigned);
+    u->cq_sz=p.cq_off.cqes+p.cq_entries*sizeof(struct io_uring_cqe);
+    u->sqes_sz=p.sq_entries*sizeof(struct io_uring_sqe);
+    u->sq_ptr=mmap(0,u->sq_sz,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,u->fd,IORING_OFF_SQ_RING);
+    u->cq_ptr=mmap(0,u->cq_sz,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,u->fd,IORING_OFF_CQ_RING);
+    u->sqes=mmap(0,u->sqes_sz,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,u->fd,IORING_OFF_SQES);
+    if(u->sq_ptr==MAP_FAILED || u->cq_ptr==MAP_FAILED || u->sqes==MAP_FAILED){ close(u->fd); return -1; }
+    u->sq_tail=(unsigned*)((char*)u->sq_ptr+p.sq_off.tail);
+    u->sq_mask=(unsigned*)((char*)u->sq_ptr+p.sq_off.ring_mask);
+    u->sq_array=(unsigned*)((char*)u->sq_ptr+p.sq_off.array);
+    u->cq_head=(unsigned*)((char*)u->cq_ptr+p.cq_off.head);
+    u->cq_tail=(unsigned*)((char*)u->cq_ptr+p.cq_off.tail);
+    u->cq_mask=(unsigned*)((char*)u->cq_ptr+p.cq_off.ring_mask);
+    u->cqes=(struct io_uring_cqe*)((char*)u->cq_ptr+p.cq_off.cqes);
+    return 0;
+}
+
+void uring_free(struct uring* u){
+    munmap(u->sqes,u->sqes_sz); munmap(u->cq_ptr,u->cq_sz); munmap(u->sq_ptr,u->sq_sz);
+    close(u->fd);
+}
+
+void uring_prep_read(struct uring* u, int fd, int slot, off_t off){
+    unsigned tail=*u->sq_tail, idx=tail&*u->sq_mask;
+    struct io_uring_sqe* sqe=&u->sqes[idx];
+    memset(sqe,0,sizeof(*sqe));
+    sqe->opcode=IORING_OP_READ; sqe->fd=fd;
+    sqe->addr=(__u64)(ring+slot*BLOCK); sqe->len=BLOCK; sqe->off=off;
+    sqe->user_data=slot;
+    u->sq_array[idx]=idx;
+    __atomic_store_n(u->sq_tail,tail+1,__ATOMIC_RELEASE);
+}
+
+double run_uring(int fd, int qd){
+    struct uring u;
+    if(uring_init(&u,qd)) return -1;
+    size_t next=0, done=0;
+    unsigned pending=0;
+    double t0=now_sec();
+    for(int s=0;s<qd;s++){ uring_prep_read(&u,fd,s,offs[next++]); pending++; }
+    while(done<NBLK){
+        if(syscall(__NR_io_uring_enter,u.fd,pending,1,IORING_ENTER_GETEVENTS,NULL,0)<0){ uring_free(&u); return -1; }
+        pending=0;
+        unsigned head=*u.cq_head, tail=__atomic_load_n(u.cq_tail,__ATOMIC_ACQUIRE);
+        for(; head!=tail; head++){
+            struct io_uring_cqe* cqe=&u.cqes[head&*u.cq_mask];
+            if(cqe->res!=BLOCK){ uring_free(&u); return -1; }
+            done++;
+            if(next<NBLK){ uring_prep_read(&u,fd,(int)cqe->user_data,offs[next++]); pending++; }
+        }
+        __atomic_store_n(u.cq_head,head,__ATOMIC_RELEASE);
+    }
+    double t=now_sec()-t0;
+    uring_free(&u);
+    return t;
+}
+
 int main(){
     const char* f="aio_test.dat";
     make_file(f);
-    int fd=open(f,O_RDONLY);
-    char buf[BLOCK];
-    struct aiocb cb; memset(&cb,0,sizeof(cb));
-    cb.aio_fildes=fd; cb.aio_buf=buf; cb.aio_nbytes=BLOCK;
+    if(posix_memalign((void**)&ring,4096,MAX_QD*BLOCK)) return 1;
 
-    // synchronous
-    double t0=now_sec();
-    for(size_t off=0; off<FILE_SIZE; off+=BLOCK)
-        pread(fd,buf,BLOCK,off);
-    double t1=now_sec();
-    printf("sync_io,%.3f\n",t1-t0);
-
-    // asynchronous
-    t0=now_sec();
-    for(size_t off=0; off<FILE_SIZE; off+=BLOCK){
-        cb.aio_offset=off;
-        aio_read(&cb);
-        while(aio_error(&cb)==EINPROGRESS);
-        aio_return(&cb);
+    // random 4 KiB reads over the whole file, so readahead cannot hide the latency
+    srand(42);
+    for(size_t i=0;i<NBLK;i++) offs[i]=(off_t)i*BLOCK;
+    for(size_t i=NBLK-1;i>0;i--){ size_t j=rand()%(i+1); off_t t=offs[i]; offs[i]=offs[j]; offs[j]=t; }
+
+    const char* names[]={"posix_aio","libaio","uring"};
+    double (*backends[])(int,int)={run_posix_aio,run_libaio,run_uring};
+    int qds[]={1,4,16,64};
+
+    for(int c=CACHE_HOT;c<=CACHE_DIRECT;c++){
+        int fd=open_mode(f,c);
+        double t=run_sync(fd,1);
+        close(fd);
+        if(t>=0) printf("sync_%s,%.3f\n",cache_names[c],t);
+
+        for(int b=0;b<3;b++){
+            for(int q=0;q<4;q++){
+                fd=open_mode(f,c);
+                t=backends[b](fd,qds[q]);
+                close(fd);
+                if(t>=0) printf("%s_qd%d_%s,%.3f\n",names[b],qds[q],cache_names[c],t);
+                else fprintf(stderr,"%s qd=%d %s unavailable: %s\n",names[b],qds[q],cache_names[c],strerror(errno));
+            }
+        }
     }
-    t1=now_sec();
-    printf("async_aio,%.3f\n",t1-t0);
-    close(fd);
+    free(ring);
     return 0;
 }
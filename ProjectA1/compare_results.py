@@ -1,7 +1,8 @@
 #!/usr/bin/env python3
 """
 ECSE 4320 Project A1 — Paired Speedup Plot Generator
-Computes speedup between paired modes in each benchmark CSV and plots 4 bars.
+Computes the speedup of a fixed candidate mode over a baseline mode in each
+benchmark CSV and plots one bar per benchmark.
 """
 
 import os
@@ -12,25 +13,43 @@ RESULTS_DIR = "results"
 OUTPUT_DIR = "plots"
 os.makedirs(OUTPUT_DIR, exist_ok=True)
 
+# (baseline, candidate) per benchmark, chosen so the two modes differ in one
+# setting only. {threads} is the largest thread count in the run.
+# wakeup_latency is left out: its Time_s is a round-trip total, and its
+# percentiles are plotted by plot_results.py.
+PAIRS = {
+    "async_io": ("sync_direct", "uring_qd16_direct"),
+    "zero_copy_io": ("read_write_64K", "sendfile_64K"),
+    "scheduler_affinity": ("sharing_none_t{threads}", "sharing_compact_t{threads}"),
+    "smt_interference": ("int_alu_vs_int_alu_smt", "int_alu_vs_int_alu_cross"),
+    "stream_read": ("buffered_1M_cold", "direct_dbuf_1M_cold"),
+}
+
 def compute_paired_speedup(csv_path):
     """
-    For each CSV, compute average speedup between the two modes.
-    speedup = slower_time / faster_time
-    Returns: (benchmark_name, avg_speedup)
+    For each run, speedup = baseline_time / candidate_time for the
+    benchmark's pair in PAIRS.
+    Returns: (benchmark_name, avg_speedup), or None if the CSV has no pair
     """
     df = pd.read_csv(csv_path)
     benchmark = os.path.splitext(os.path.basename(csv_path))[0]
+    if benchmark not in PAIRS:
+        print(f"ℹ️ {benchmark}: no baseline/candidate pair, see plot_results.py")
+        return None
 
-    # Group by Run, compute speedup per run
     speedups = []
     for run, group in df.groupby("Run"):
-        times = group.set_index("Mode")["Time_s"]
-        if len(times) != 2:
-            raise ValueError(f"Run {run} in {csv_path} does not have exactly 2 modes")
-        faster = times.min()
-        slower = times.max()
-        speedups.append(slower / faster)
+        times = group.groupby("Mode")["Time_s"].mean()
+        threads = group["Mode"].str.extract(r"_t(\d+)$")[0].dropna().astype(int)
+        fill = {"threads": threads.max() if not threads.empty else 1}
+        baseline, candidate = (m.format(**fill) for m in PAIRS[benchmark])
+        if baseline not in times or candidate not in times:
+            print(f"⚠️ {benchmark} run {run}: missing {baseline} or {candidate}, skipped")
+            continue
+        speedups.append(times[baseline] / times[candidate])
 
+    if not speedups:
+        return None
     avg_speedup = sum(speedups) / len(speedups)
     return benchmark, avg_speedup
 
@@ -43,15 +62,20 @@ def main():
     benchmarks = []
     speedup_values = []
 
-    for csv in csv_files:
-        benchmark, avg_speedup = compute_paired_speedup(os.path.join(RESULTS_DIR, csv))
-        benchmarks.append(benchmark)
-        speedup_values.append(avg_speedup)
+    for csv in sorted(csv_files):
+        result = compute_paired_speedup(os.path.join(RESULTS_DIR, csv))
+        if result is None:
+            continue
+        benchmarks.append(result[0])
+        speedup_values.append(result[1])
+    if not benchmarks:
+        print("⚠️ No benchmark CSV had its baseline/candidate pair.")
+        return
 
     # === Plotting ===
     plt.figure(figsize=(8,6))
     bars = plt.bar(benchmarks, speedup_values, color="#4C72B0", alpha=0.85)
-    plt.ylabel("Average Speedup (slower/faster)", fontsize=12)
+    plt.ylabel("Average Speedup (baseline/candidate)", fontsize=12)
     plt.title("Paired Speedup Across Benchmarks", fontsize=14, weight='bold')
     plt.grid(axis='y', linestyle='--', alpha=0.5)
 
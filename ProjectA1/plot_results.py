@@ -27,13 +27,15 @@ def plot_csv(csv_path):
     grouped['Error'] = df.groupby('Mode')['Time_s'].std().reindex(grouped['Mode']).values
 
     # === Plot ===
-    plt.figure(figsize=(6, 4))
+    plt.figure(figsize=(max(6, 0.4 * len(grouped)), 4))
     bars = plt.bar(grouped['Mode'], grouped['Time_s'], yerr=grouped['Error'],
                    capsize=5, color="#4C72B0", alpha=0.85)
     plt.xlabel("Mode", fontsize=11)
     plt.ylabel("Average Runtime (s)", fontsize=11)
     plt.title(f"{benchmark.replace('_',' ').title()} Benchmark", fontsize=13, weight='bold')
     plt.grid(axis='y', linestyle='--', alpha=0.5)
+    if len(grouped) > 4:
+        plt.xticks(rotation=60, ha='right', fontsize=8)
 
     # Annotate bar values
     for bar, val in zip(bars, grouped['Time_s']):
@@ -46,6 +48,51 @@ def plot_csv(csv_path):
     plt.close()
     print(f"✅ Saved plot: {out_path}")
 
+def plot_smt_matrix(csv_path):
+    """Heatmaps of victim slowdown (paired time / alone time) from smt_interference.csv."""
+    df = pd.read_csv(csv_path)
+    times = df.groupby('Mode')['Time_s'].mean()
+    alone = {m[:-len('_alone')]: t for m, t in times.items() if m.endswith('_alone')}
+    names = list(alone)
+
+    for kind in ['smt', 'cross']:
+        matrix = [[times.get(f"{a}_vs_{b}_{kind}", float('nan')) / alone[a] for b in names] for a in names]
+        if all(pd.isna(v) for row in matrix for v in row):
+            continue
+        plt.figure(figsize=(8, 6.5))
+        plt.imshow(matrix, cmap='Reds', vmin=1.0)
+        plt.colorbar(label='Slowdown vs alone')
+        plt.xticks(range(len(names)), names, rotation=45, ha='right')
+        plt.yticks(range(len(names)), names)
+        for i in range(len(names)):
+            for j in range(len(names)):
+                plt.text(j, i, f"{matrix[i][j]:.2f}", ha='center', va='center', fontsize=8)
+        plt.xlabel("Co-runner")
+        plt.ylabel("Measured workload")
+        where = "SMT Siblings" if kind == 'smt' else "Separate Cores"
+        plt.title(f"Interference Matrix ({where})", fontsize=13, weight='bold')
+        plt.tight_layout()
+        out_path = os.path.join(OUTPUT_DIR, f"smt_matrix_{kind}.png")
+        plt.savefig(out_path, dpi=200)
+        plt.close()
+        print(f"✅ Saved plot: {out_path}")
+
+def plot_wakeup_latency(csv_path):
+    """Grouped P50/P99/P99.9 round-trip latency bars (log scale) from wakeup_latency.csv."""
+    df = pd.read_csv(csv_path)
+    grouped = df.groupby('Mode')[['P50_us', 'P99_us', 'P999_us']].mean().sort_values('P50_us')
+    ax = grouped.plot.bar(figsize=(max(8, 0.5 * len(grouped)), 4.5), logy=True, width=0.8)
+    ax.set_xlabel("Primitive_Placement")
+    ax.set_ylabel("Round-trip latency (us, log)")
+    ax.set_title("Wakeup Latency Percentiles", fontsize=13, weight='bold')
+    ax.grid(axis='y', linestyle='--', alpha=0.5)
+    plt.xticks(rotation=60, ha='right', fontsize=8)
+    plt.tight_layout()
+    out_path = os.path.join(OUTPUT_DIR, "wakeup_latency_percentiles.png")
+    plt.savefig(out_path, dpi=200)
+    plt.close()
+    print(f"✅ Saved plot: {out_path}")
+
 def main():
     csv_files = [f for f in os.listdir(RESULTS_DIR) if f.endswith(".csv")]
     if not csv_files:
@@ -54,6 +101,10 @@ def main():
 
     for csv in csv_files:
         plot_csv(os.path.join(RESULTS_DIR, csv))
+        if csv == "smt_interference.csv":
+            plot_smt_matrix(os.path.join(RESULTS_DIR, csv))
+        if csv == "wakeup_latency.csv":
+            plot_wakeup_latency(os.path.join(RESULTS_DIR, csv))
 
     print("\nAll plots generated in the 'plots/' folder.")
 
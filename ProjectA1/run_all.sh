@@ -15,6 +15,15 @@ declare -A FILES=(
  ["async_io"]="async_io"
  ["scheduler_affinity"]="scheduler_affinity"
  ["smt_interference"]="smt_interference"
+ ["wakeup_latency"]="wakeup_latency"
+ ["stream_read"]="stream_read"
+)
+
+# Benchmarks that print extra columns after Mode,Time_s
+declare -A HEADERS=(
+ ["zero_copy_io"]="Run,Mode,Time_s,GBps,CPU_s_per_GB"
+ ["wakeup_latency"]="Run,Mode,Time_s,P50_us,P99_us,P999_us"
+ ["stream_read"]="Run,Mode,Time_s,GBps,CPU_s_per_GB"
 )
 
 # ==========================================================
@@ -23,7 +32,7 @@ declare -A FILES=(
 run_bench () {
     exe=$1
     csv="results/${exe}.csv"
-    echo "Run,Mode,Time_s" > "$csv"
+    echo "${HEADERS[$exe]:-Run,Mode,Time_s}" > "$csv"
 
     for i in {1..3}; do
         echo "[$exe] run $i"
@@ -4,9 +4,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include "topology.h"
 
-#define N (2L*1000*1000*100) // 200 million iterations per thread
-#define NUM_THREADS 2
+#define N (2L*1000*1000*100) // 200 million iterations per thread (compute)
+#define MEM_BYTES (32L*1024*1024) // per-thread buffer, well past L2 (memory)
+#define MEM_PASSES 64
+#define SHARED_OPS (20L*1000*1000) // atomic updates per thread (sharing)
+#define SHARED_LINES 8 // cache lines all threads hammer
+
+enum workload { W_COMPUTE, W_MEMORY, W_SHARING };
+static const char* workload_names[] = {"compute", "memory", "sharing"};
+
+// shared counters, one per cache line
+static struct { volatile long v; char pad[56]; } shared[SHARED_LINES] __attribute__((aligned(64)));
 
 double now_sec() {
     struct timespec ts;
@@ -14,8 +24,8 @@ double now_sec() {
     return ts.tv_sec + ts.tv_nsec/1e9;
 }
 
-// Workload that cannot be optimized away
-void* work(void* arg) {
+// Compute-bound: register-resident FP loop that cannot be optimized away
+void* work_compute(void* arg) {
     double x = 0.0;
     for(long i = 0; i < N; i++) {
         x += i * 0.0000001;
@@ -27,6 +37,30 @@ void* work(void* arg) {
     return NULL;
 }
 
+// Memory-bound: stream over a private buffer larger than any per-core cache
+void* work_memory(void* arg) {
+    long n = MEM_BYTES / sizeof(long);
+    long* buf = malloc(MEM_BYTES);
+    for(long i = 0; i < n; i++) buf[i] = i; // first touch on the pinned CPU
+    long sum = 0;
+    for(int p = 0; p < MEM_PASSES; p++)
+        for(long i = 0; i < n; i++) sum += buf[i];
+    volatile long sink = sum;
+    (void)sink;
+    free(buf);
+    return NULL;
+}
+
+// Sharing-heavy: every thread does atomic updates on the same few cache lines
+void* work_sharing(void* arg) {
+    unsigned seed = (unsigned)(long)arg;
+    for(long i = 0; i < SHARED_OPS; i++) {
+        seed = seed * 1103515245 + 12345;
+        __atomic_fetch_add(&shared[(seed >> 16) % SHARED_LINES].v, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
 // pin a pthread_attr to a CPU
 void set_affinity(pthread_attr_t* attr, int cpu) {
     cpu_set_t set;
@@ -35,42 +69,52 @@ void set_affinity(pthread_attr_t* attr, int cpu) {
     pthread_attr_setaffinity_np(attr, sizeof(set), &set);
 }
 
-int main() {
-    pthread_t threads[NUM_THREADS];
-    pthread_attr_t attrs[NUM_THREADS];
-    double t0, t1s;
-
-    // -------------------------------
-    // Mode 1: no affinity
-    // -------------------------------
-    for(int i = 0; i < NUM_THREADS; i++)
+// Runs n_threads copies of the workload, placed by policy; returns wall time
+double run(enum workload w, enum placement p, const int* order, int ncpu, int n_threads) {
+    void* (*fn[])(void*) = {work_compute, work_memory, work_sharing};
+    pthread_t threads[n_threads];
+    pthread_attr_t attrs[n_threads];
+
+    for(int i = 0; i < n_threads; i++) {
         pthread_attr_init(&attrs[i]);
+        if (p != PLACE_NONE) set_affinity(&attrs[i], order[i % ncpu]);
+    }
 
-    t0 = now_sec();
-    for(int i = 0; i < NUM_THREADS; i++)
-        pthread_create(&threads[i], &attrs[i], work, NULL);
+    double t0 = now_sec();
+    for(int i = 0; i < n_threads; i++)
+        pthread_create(&threads[i], &attrs[i], fn[w], (void*)(long)(i + 1));
 
-    for(int i = 0; i < NUM_THREADS; i++)
+    for(int i = 0; i < n_threads; i++)
         pthread_join(threads[i], NULL);
-    t1s = now_sec();
-    printf("no_affinity,%.3f\n", t1s - t0);
+    double t1 = now_sec();
 
-    // -------------------------------
-    // Mode 2: pinned to specific cores
-    // -------------------------------
-    for(int i = 0; i < NUM_THREADS; i++) {
-        pthread_attr_init(&attrs[i]);
-        set_affinity(&attrs[i], i); // thread i -> core i
-    }
+    for(int i = 0; i < n_threads; i++)
+        pthread_attr_destroy(&attrs[i]);
+    return t1 - t0;
+}
 
-    t0 = now_sec();
-    for(int i = 0; i < NUM_THREADS; i++)
-        pthread_create(&threads[i], &attrs[i], work, NULL);
+int main() {
+    static struct topology topo;
+    topo_read(&topo);
+    topo_print(&topo, stderr);
+    fprintf(stderr, "%d logical CPUs, %d physical cores\n", topo.n, topo_n_cores(&topo));
 
-    for(int i = 0; i < NUM_THREADS; i++)
-        pthread_join(threads[i], NULL);
-    t1s = now_sec();
-    printf("pinned_affinity,%.3f\n", t1s - t0);
+    int order[PLACE_SMT_AVOID + 1][TOPO_MAX_CPUS];
+    for(int p = PLACE_NONE; p <= PLACE_SMT_AVOID; p++)
+        topo_order(&topo, p, order[p]);
+
+    // thread counts: powers of two up to all logical CPUs, plus all of them
+    int counts[32], n_counts = 0;
+    for(int t = 1; t < topo.n; t *= 2) counts[n_counts++] = t;
+    counts[n_counts++] = topo.n;
+
+    // Each thread does a fixed amount of work, so ideal scaling keeps time flat.
+    // Mode names: <workload>_<policy>_t<threads>
+    for(int w = W_COMPUTE; w <= W_SHARING; w++)
+        for(int c = 0; c < n_counts; c++)
+            for(int p = PLACE_NONE; p <= PLACE_SMT_AVOID; p++)
+                printf("%s_%s_t%d,%.3f\n", workload_names[w], placement_names[p], counts[c],
+                       run(w, p, order[p], topo.n, counts[c]));
 
     return 0;
 }
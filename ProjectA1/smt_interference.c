@@ -3,9 +3,15 @@
 #include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <immintrin.h>
+#include "topology.h"
 
-#define N (2L*500*1000*1000) // 1 billion iterations per thread
+#define TARGET_SEC 0.3 // calibrated runtime of each workload when alone
+#define L1_BYTES (16 * 1024)
+#define DRAM_BYTES (64L * 1024 * 1024)
+#define CHASE_BYTES (32L * 1024 * 1024)
 
 double now_sec() {
     struct timespec ts;
@@ -13,58 +19,250 @@ double now_sec() {
     return ts.tv_sec + ts.tv_nsec/1e9;
 }
 
-// Workload: heavy floating-point loop
-void* work(void* arg){
-    volatile double x = 0;
-    for(long i = 0; i < N; i++)
-        x += i * 0.0000001;
+// Per-thread buffers, allocated before timing starts
+struct ctx {
+    long* l1;       // L1-resident array (also branch-pattern source)
+    long* dram;     // streaming buffer, far past LLC
+    size_t* chase;  // random single-cycle permutation
+    size_t pos;
+};
+
+// -------------------------------
+// Microworkloads: each does `reps` units of work and returns a value to sink
+// -------------------------------
+long wl_int_alu(struct ctx* c, long reps) {
+    unsigned long a = 1, b = 2, d = 3, e = 4;
+    for (long i = 0; i < reps * 1000; i++) {
+        a = (a + i) ^ (b >> 3);
+        b = (b * 7) + (d ^ i);
+        d = (d << 1) ^ (e + a);
+        e = (e - b) | (i & 0xff);
+    }
+    return a + b + d + e;
+}
+
+__attribute__((target("fma")))
+long wl_fp_fma(struct ctx* c, long reps) {
+    double a = 1.0, b = 1.1, d = 1.2, e = 1.3, m = 0.9999999, k = 1e-9;
+    for (long i = 0; i < reps * 1000; i++) {
+        __asm__ ("" : "+x"(m)); // keep the loop from being folded
+        a = __builtin_fma(a, m, k); b = __builtin_fma(b, m, k);
+        d = __builtin_fma(d, m, k); e = __builtin_fma(e, m, k);
+    }
+    return (long)(a + b + d + e);
+}
+
+__attribute__((target("avx2")))
+long wl_simd(struct ctx* c, long reps) {
+    __m256i v[6], inc = _mm256_set1_epi32(0x9e3779b9), mul = _mm256_set1_epi32(33);
+    for (int j = 0; j < 6; j++) v[j] = _mm256_set1_epi32(j + 1);
+    for (long i = 0; i < reps * 1000; i++) {
+        __asm__ ("" : "+x"(inc));
+        for (int j = 0; j < 6; j++)
+            v[j] = _mm256_xor_si256(_mm256_mullo_epi32(_mm256_add_epi32(v[j], inc), mul), v[(j + 1) % 6]);
+    }
+    __m256i s = v[0];
+    for (int j = 1; j < 6; j++) s = _mm256_add_epi32(s, v[j]);
+    return _mm256_extract_epi32(s, 0);
+}
+
+long wl_l1_load(struct ctx* c, long reps) {
+    long s0 = 0, s1 = 0, n = L1_BYTES / sizeof(long);
+    for (long r = 0; r < reps; r++) {
+        __asm__ volatile ("" ::: "memory");
+        for (long i = 0; i < n; i += 2) { s0 += c->l1[i]; s1 += c->l1[i + 1]; }
+    }
+    return s0 + s1;
+}
+
+long wl_dram_stream(struct ctx* c, long reps) {
+    long s = 0, n = DRAM_BYTES / sizeof(long), chunk = n / 64;
+    for (long r = 0; r < reps; r++) { // each rep streams 1/64th of the buffer
+        long base = (r % 64) * chunk;
+        for (long i = base; i < base + chunk; i++) s += c->dram[i];
+    }
+    return s;
+}
+
+long wl_branch(struct ctx* c, long reps) {
+    long s = 0, n = L1_BYTES / sizeof(long);
+    for (long r = 0; r < reps; r++)
+        for (long i = 0; i < n; i++) {
+            long x = c->l1[i];
+            // the empty asm in each arm keeps GCC from if-converting to cmov,
+            // so these stay real branches on random bits (~50% mispredicted)
+            if (x & 1) { __asm__ volatile (""); s += x; } else { __asm__ volatile (""); s -= 3; }
+            if (x & 2) { __asm__ volatile (""); s ^= i; }
+        }
+    return s;
+}
+
+long wl_pointer_chase(struct ctx* c, long reps) {
+    size_t p = c->pos;
+    for (long i = 0; i < reps * 100; i++) p = c->chase[p];
+    c->pos = p;
+    return (long)p;
+}
+
+struct workload {
+    const char* name;
+    long (*fn)(struct ctx*, long);
+    const char* isa; // required CPU feature, or NULL
+    long reps;       // calibrated to TARGET_SEC
+};
+
+static struct workload wls[] = {
+    {"int_alu",       wl_int_alu,       NULL},
+    {"fp_fma",        wl_fp_fma,        "fma"},
+    {"simd",          wl_simd,          "avx2"},
+    {"l1_load",       wl_l1_load,       NULL},
+    {"dram_stream",   wl_dram_stream,   NULL},
+    {"branch",        wl_branch,        NULL},
+    {"pointer_chase", wl_pointer_chase, NULL},
+};
+#define N_WL ((int)(sizeof(wls) / sizeof(wls[0])))
+
+void ctx_init(struct ctx* c, int w) {
+    memset(c, 0, sizeof(*c));
+    unsigned seed = 12345;
+    c->l1 = malloc(L1_BYTES);
+    for (size_t i = 0; i < L1_BYTES / sizeof(long); i++) c->l1[i] = rand_r(&seed);
+    if (wls[w].fn == wl_dram_stream) {
+        c->dram = malloc(DRAM_BYTES);
+        for (size_t i = 0; i < DRAM_BYTES / sizeof(long); i++) c->dram[i] = i;
+    }
+    if (wls[w].fn == wl_pointer_chase) {
+        size_t n = CHASE_BYTES / sizeof(size_t);
+        size_t* perm = malloc(n * sizeof(size_t));
+        for (size_t i = 0; i < n; i++) perm[i] = i;
+        for (size_t i = n - 1; i > 0; i--) {
+            size_t j = ((size_t)rand_r(&seed) << 16 ^ rand_r(&seed)) % (i + 1);
+            size_t t = perm[i]; perm[i] = perm[j]; perm[j] = t;
+        }
+        c->chase = malloc(n * sizeof(size_t));
+        for (size_t i = 0; i < n; i++) c->chase[perm[i]] = perm[(i + 1) % n];
+        free(perm);
+    }
+}
+
+void ctx_free(struct ctx* c) { free(c->l1); free(c->dram); free(c->chase); }
+
+// -------------------------------
+// Co-scheduling: the victim runs its calibrated work once and is timed;
+// the aggressor repeats its workload until the victim is done
+// -------------------------------
+struct job {
+    int w, cpu, victim;
+    double time;
+    pthread_barrier_t* start;
+    volatile int* stop;
+};
+
+void* run_job(void* arg) {
+    struct job* j = arg;
+    cpu_set_t set; CPU_ZERO(&set); CPU_SET(j->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    struct ctx c; ctx_init(&c, j->w);
+    long sink = 0;
+    pthread_barrier_wait(j->start);
+    if (j->victim) {
+        double t0 = now_sec();
+        sink += wls[j->w].fn(&c, wls[j->w].reps);
+        j->time = now_sec() - t0;
+        *j->stop = 1;
+    } else {
+        long step = wls[j->w].reps / 50 + 1;
+        while (!*j->stop) sink += wls[j->w].fn(&c, step);
+    }
+    volatile long s = sink; (void)s;
+    ctx_free(&c);
     return NULL;
 }
 
-// Pin a pthread_attr to a single CPU
-void set_affinity(pthread_attr_t* attr, int cpu) {
-    cpu_set_t set;
-    CPU_ZERO(&set);
-    CPU_SET(cpu, &set);
-    pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+// Time of workload a on cpu_a while workload b (or nothing, b < 0) runs on cpu_b
+double co_run(int a, int cpu_a, int b, int cpu_b) {
+    pthread_barrier_t start;
+    volatile int stop = 0;
+    pthread_barrier_init(&start, NULL, b < 0 ? 1 : 2);
+    struct job ja = {a, cpu_a, 1, 0, &start, &stop}, jb = {b, cpu_b, 0, 0, &start, &stop};
+    pthread_t ta, tb;
+    pthread_create(&ta, NULL, run_job, &ja);
+    if (b >= 0) pthread_create(&tb, NULL, run_job, &jb);
+    pthread_join(ta, NULL);
+    if (b >= 0) pthread_join(tb, NULL);
+    pthread_barrier_destroy(&start);
+    return ja.time;
+}
+
+// Double reps until one run takes 50 ms, then scale to TARGET_SEC
+void calibrate(int w, int cpu) {
+    wls[w].reps = 1;
+    double t;
+    while ((t = co_run(w, cpu, -1, -1)) < 0.05) wls[w].reps *= 2;
+    wls[w].reps = (long)(wls[w].reps * TARGET_SEC / t) + 1;
+}
+
+void print_matrix(const char* title, double m[N_WL][N_WL], const int* ok) {
+    fprintf(stderr, "\n%s: slowdown of row workload when paired with column workload\n%-14s", title, "");
+    for (int b = 0; b < N_WL; b++) if (ok[b]) fprintf(stderr, "%14s", wls[b].name);
+    fprintf(stderr, "\n");
+    for (int a = 0; a < N_WL; a++) {
+        if (!ok[a]) continue;
+        fprintf(stderr, "%-14s", wls[a].name);
+        for (int b = 0; b < N_WL; b++) if (ok[b]) fprintf(stderr, "%14.2f", m[a][b]);
+        fprintf(stderr, "\n");
+    }
 }
 
 int main() {
-    pthread_t t1, t2;
-    pthread_attr_t attr1, attr2;
-    double t0, t1s;
-
-    // -------------------------------
-    // Mode 1: Both threads on SAME core
-    // -------------------------------
-    pthread_attr_init(&attr1);
-    pthread_attr_init(&attr2);
-    set_affinity(&attr1, 0);
-    set_affinity(&attr2, 0); // same logical core -> SMT contention
-
-    t0 = now_sec();
-    pthread_create(&t1, &attr1, work, NULL);
-    pthread_create(&t2, &attr2, work, NULL);
-    pthread_join(t1, NULL);
-    pthread_join(t2, NULL);
-    t1s = now_sec();
-    printf("shared_core,%.3f\n", t1s - t0);
-
-    // -------------------------------
-    // Mode 2: Threads on DIFFERENT cores
-    // -------------------------------
-    pthread_attr_init(&attr1);
-    pthread_attr_init(&attr2);
-    set_affinity(&attr1, 0);
-    set_affinity(&attr2, 1); // separate cores
-
-    t0 = now_sec();
-    pthread_create(&t1, &attr1, work, NULL);
-    pthread_create(&t2, &attr2, work, NULL);
-    pthread_join(t1, NULL);
-    pthread_join(t2, NULL);
-    t1s = now_sec();
-    printf("separate_core,%.3f\n", t1s - t0);
+    static struct topology topo;
+    topo_read(&topo);
+
+    // Real SMT sibling pair, and a second physical core for the cross-core control
+    int smt_a = -1, smt_b = -1, other_core = -1;
+    for (int i = 0; i < topo.n && smt_a < 0; i++)
+        if (topo.cpus[i].smt == 0 && topo_sibling(&topo, topo.cpus[i].cpu, 1) >= 0) {
+            smt_a = topo.cpus[i].cpu;
+            smt_b = topo_sibling(&topo, smt_a, 1);
+        }
+    int base = smt_a >= 0 ? smt_a : topo.cpus[0].cpu;
+    for (int i = 0; i < topo.n; i++)
+        if (topo.cpus[i].smt == 0 && topo.cpus[i].cpu != base) { other_core = topo.cpus[i].cpu; break; }
+    if (smt_a < 0) fprintf(stderr, "No SMT sibling pair found (SMT off or single-threaded cores)\n");
+    else fprintf(stderr, "SMT siblings: cpu %d + cpu %d\n", smt_a, smt_b);
+    if (other_core >= 0) fprintf(stderr, "Cross-core control: cpu %d + cpu %d\n", base, other_core);
+
+    int ok[N_WL];
+    double alone[N_WL], smt[N_WL][N_WL], cross[N_WL][N_WL];
+    __builtin_cpu_init();
+    for (int w = 0; w < N_WL; w++) {
+        ok[w] = !wls[w].isa || (!strcmp(wls[w].isa, "fma") ? __builtin_cpu_supports("fma")
+                                                            : __builtin_cpu_supports("avx2"));
+        if (!ok[w]) { fprintf(stderr, "%s skipped: no %s\n", wls[w].name, wls[w].isa); continue; }
+        calibrate(w, base);
+        alone[w] = co_run(w, base, -1, -1);
+        printf("%s_alone,%.3f\n", wls[w].name, alone[w]);
+    }
+
+    // Mode names: <victim>_vs_<aggressor>_<smt|cross>, time is the victim's runtime
+    for (int a = 0; a < N_WL; a++) {
+        if (!ok[a]) continue;
+        for (int b = 0; b < N_WL; b++) {
+            if (!ok[b]) continue;
+            if (smt_a >= 0) {
+                double t = co_run(a, smt_a, b, smt_b);
+                smt[a][b] = t / alone[a];
+                printf("%s_vs_%s_smt,%.3f\n", wls[a].name, wls[b].name, t);
+            }
+            if (other_core >= 0) {
+                double t = co_run(a, base, b, other_core);
+                cross[a][b] = t / alone[a];
+                printf("%s_vs_%s_cross,%.3f\n", wls[a].name, wls[b].name, t);
+            }
+        }
+    }
 
+    if (smt_a >= 0) print_matrix("SMT siblings", smt, ok);
+    if (other_core >= 0) print_matrix("Separate physical cores", cross, ok);
     return 0;
 }
@@ -0,0 +1,216 @@
+#define _GNU_SOURCE
+#include <aio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#define FILE_SIZE (512L * 1024 * 1024) // 512 MB, well past readahead windows
+#define WILLNEED_AHEAD (32L * 1024 * 1024) // how far ahead fadvise_willneed hints
+
+enum cache_mode { CACHE_HOT, CACHE_COLD };
+static const char* cache_names[] = {"hot", "cold"};
+
+static volatile long sink; // keeps the scan over the data from being dropped
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// user + system CPU time of the whole process (includes glibc AIO helper threads)
+double cpu_sec() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+void make_file(const char* f) {
+    int fd = open(f, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    static char buf[1 << 20];
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (char)i;
+    for (long i = 0; i < FILE_SIZE / (long)sizeof(buf); i++)
+        write(fd, buf, sizeof(buf));
+    fsync(fd);
+    close(fd);
+}
+
+// Evict the file from the page cache (system-wide drop too, when running as root)
+void drop_cache(const char* f) {
+    int fd = open(f, O_RDONLY);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    int dc = open("/proc/sys/vm/drop_caches", O_WRONLY);
+    if (dc >= 0) { sync(); write(dc, "1", 1); close(dc); }
+}
+
+void warm_cache(const char* f) {
+    int fd = open(f, O_RDONLY);
+    static char buf[1 << 20];
+    while (read(fd, buf, sizeof(buf)) > 0);
+    close(fd);
+}
+
+// Every strategy touches one byte per cache line, like a scanner would
+long consume(const char* p, size_t n) {
+    long s = 0;
+    for (size_t i = 0; i < n; i += 64) s += p[i];
+    return s;
+}
+
+// -------------------------------
+// read() based strategies; advice is set up before the loop
+// -------------------------------
+int read_loop(int fd, char* buf, size_t bs, int willneed) {
+    long s = 0, advised = 0;
+    for (long pos = 0; pos < FILE_SIZE; ) {
+        // keep a hint window WILLNEED_AHEAD bytes in front of the reader
+        while (willneed && advised < FILE_SIZE && advised < pos + WILLNEED_AHEAD) {
+            long step = bs > (1 << 20) ? (long)bs : (1 << 20);
+            posix_fadvise(fd, advised, step, POSIX_FADV_WILLNEED);
+            advised += step;
+        }
+        ssize_t n = read(fd, buf, bs);
+        if (n <= 0) return -1;
+        s += consume(buf, n);
+        pos += n;
+    }
+    sink = s;
+    return 0;
+}
+
+int read_buffered(int fd, char* buf, size_t bs) {
+    return read_loop(fd, buf, bs, 0);
+}
+
+int read_fadvise_seq(int fd, char* buf, size_t bs) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return read_loop(fd, buf, bs, 0);
+}
+
+int read_fadvise_willneed(int fd, char* buf, size_t bs) {
+    return read_loop(fd, buf, bs, 1);
+}
+
+// -------------------------------
+// O_DIRECT with two buffers: the next chunk is in flight (POSIX AIO)
+// while the current one is scanned
+// -------------------------------
+int read_direct_dbuf(int fd, char* buf, size_t bs) {
+    char* half[2] = {buf, buf + bs};
+    struct aiocb cb[2];
+    memset(cb, 0, sizeof(cb));
+    long s = 0, next = 0;
+    for (int i = 0; i < 2; i++) { cb[i].aio_fildes = fd; cb[i].aio_buf = half[i]; cb[i].aio_nbytes = bs; }
+
+    cb[0].aio_offset = next; next += bs;
+    if (aio_read(&cb[0])) return -1;
+    for (int cur = 0; ; cur ^= 1) {
+        const struct aiocb* list[1] = {&cb[cur]};
+        while (aio_error(&cb[cur]) == EINPROGRESS) aio_suspend(list, 1, NULL);
+        ssize_t n = aio_return(&cb[cur]);
+        if (n < 0) return -1;
+        if (next < FILE_SIZE) {
+            cb[cur ^ 1].aio_offset = next; next += bs;
+            if (aio_read(&cb[cur ^ 1])) return -1;
+        }
+        s += consume(half[cur], n);
+        if (cb[cur].aio_offset + n >= FILE_SIZE) break;
+    }
+    sink = s;
+    return 0;
+}
+
+// -------------------------------
+// mmap of the whole file; the buffer size does not apply
+// -------------------------------
+int map_scan(int fd, int advice) {
+    char* p = mmap(NULL, FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return -1;
+    if (madvise(p, FILE_SIZE, MADV_SEQUENTIAL)) perror("madvise(MADV_SEQUENTIAL)");
+    if (advice && madvise(p, FILE_SIZE, advice))
+        fprintf(stderr, "madvise(MADV_HUGEPAGE) on a file mapping: %s\n", strerror(errno));
+    sink = consume(p, FILE_SIZE);
+    munmap(p, FILE_SIZE);
+    return 0;
+}
+
+struct strategy {
+    const char* name;
+    int (*fn)(int, char*, size_t);
+    int direct; // opens with O_DIRECT, never served from the page cache
+};
+
+void report(const char* mode, double t, double cpu) {
+    double gb = FILE_SIZE / 1e9;
+    printf("%s,%.3f,%.3f,%.3f\n", mode, t, gb / t, cpu / gb);
+    fflush(stdout);
+}
+
+int main() {
+    const char* f = "stream_test.dat";
+    make_file(f);
+
+    struct strategy strategies[] = {
+        {"buffered",         read_buffered,         0},
+        {"fadvise_seq",      read_fadvise_seq,      0},
+        {"fadvise_willneed", read_fadvise_willneed, 0},
+        {"direct_dbuf",      read_direct_dbuf,      1},
+    };
+    size_t sizes[] = {4096, 65536, 256 << 10, 1 << 20, 8 << 20};
+    char* buf;
+    if (posix_memalign((void**)&buf, 4096, 2 * (8 << 20))) return 1;
+    memset(buf, 0, 2 * (8 << 20));
+
+    // Mode,Time_s,GBps,CPU_s_per_GB; mode is <strategy>_<buffer>_<hot|cold>
+    for (int c = CACHE_HOT; c <= CACHE_COLD; c++) {
+        for (size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+            for (size_t b = 0; b < sizeof(sizes) / sizeof(sizes[0]); b++) {
+                if (c == CACHE_HOT) warm_cache(f); else drop_cache(f);
+                int fd = open(f, O_RDONLY | (strategies[s].direct ? O_DIRECT : 0));
+                if (fd < 0) {
+                    fprintf(stderr, "%s: open: %s\n", strategies[s].name, strerror(errno));
+                    break;
+                }
+                double c0 = cpu_sec(), t0 = now_sec();
+                int rc = strategies[s].fn(fd, buf, sizes[b]);
+                double t1 = now_sec(), c1 = cpu_sec();
+                close(fd);
+                if (rc) {
+                    fprintf(stderr, "%s: %s\n", strategies[s].name, strerror(errno));
+                    break;
+                }
+                char mode[64];
+                snprintf(mode, sizeof(mode), "%s_%zu%s_%s", strategies[s].name,
+                         sizes[b] >= (1 << 20) ? sizes[b] >> 20 : sizes[b] >> 10,
+                         sizes[b] >= (1 << 20) ? "M" : "K", cache_names[c]);
+                report(mode, t1 - t0, c1 - c0);
+            }
+        }
+
+        const char* map_names[] = {"mmap_seq", "mmap_huge"};
+        int map_advice[] = {0, MADV_HUGEPAGE};
+        for (int m = 0; m < 2; m++) {
+            if (c == CACHE_HOT) warm_cache(f); else drop_cache(f);
+            int fd = open(f, O_RDONLY);
+            double c0 = cpu_sec(), t0 = now_sec();
+            int rc = map_scan(fd, map_advice[m]);
+            double t1 = now_sec(), c1 = cpu_sec();
+            close(fd);
+            if (rc) { fprintf(stderr, "%s: %s\n", map_names[m], strerror(errno)); continue; }
+            char mode[64];
+            snprintf(mode, sizeof(mode), "%s_%s", map_names[m], cache_names[c]);
+            report(mode, t1 - t0, c1 - c0);
+        }
+    }
+    free(buf);
+    unlink(f);
+    return 0;
+}
@@ -0,0 +1,143 @@
+// topology.h
+// CPU topology from sysfs (packages, cores, SMT siblings, L2/L3 domains)
+// and thread placement policies built on it.
+#pragma once
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TOPO_MAX_CPUS 1024
+
+struct cpu_info {
+    int cpu;
+    int package, core;   // core is (package, core_id) flattened to a unique id
+    int smt;             // position among the core's SMT siblings (0 = first)
+    int l2, l3;          // lowest CPU id sharing that cache, -1 if unknown
+};
+
+struct topology {
+    int n;
+    struct cpu_info cpus[TOPO_MAX_CPUS];
+};
+
+enum placement { PLACE_NONE, PLACE_COMPACT, PLACE_SCATTER, PLACE_SMT_AVOID };
+static const char* placement_names[] __attribute__((unused)) = {"none", "compact", "scatter", "smt_avoid"};
+
+static inline int topo_read_int(const char* path, int fallback) {
+    FILE* f = fopen(path, "r");
+    int v = fallback;
+    if (f) { if (fscanf(f, "%d", &v) != 1) v = fallback; fclose(f); }
+    return v;
+}
+
+// First CPU of a sysfs cpu list such as "0-3,8-11" or "2,14"
+static inline int topo_first_cpu(const char* path) {
+    return topo_read_int(path, -1);
+}
+
+// Reads the topology of every CPU this process may run on
+static inline void topo_read(struct topology* t) {
+    char path[256];
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    t->n = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && t->n < TOPO_MAX_CPUS; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        struct cpu_info* c = &t->cpus[t->n++];
+        c->cpu = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        c->package = topo_read_int(path, 0);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        c->core = c->package * 65536 + topo_read_int(path, cpu);
+        c->l2 = c->l3 = -1;
+        for (int idx = 0; idx < 8; idx++) {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, idx);
+            int level = topo_read_int(path, -1);
+            if (level < 0) break;
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, idx);
+            if (level == 2) c->l2 = topo_first_cpu(path);
+            if (level == 3) c->l3 = topo_first_cpu(path);
+        }
+    }
+    // SMT position: rank among CPUs on the same physical core
+    for (int i = 0; i < t->n; i++) {
+        t->cpus[i].smt = 0;
+        for (int j = 0; j < i; j++)
+            if (t->cpus[j].core == t->cpus[i].core) t->cpus[i].smt++;
+    }
+}
+
+static inline int topo_n_cores(const struct topology* t) {
+    int n = 0;
+    for (int i = 0; i < t->n; i++) n += t->cpus[i].smt == 0;
+    return n;
+}
+
+// Returns the CPU that is SMT sibling `smt` of the core holding `cpu`, or -1
+static inline int topo_sibling(const struct topology* t, int cpu, int smt) {
+    int core = -1;
+    for (int i = 0; i < t->n; i++) if (t->cpus[i].cpu == cpu) core = t->cpus[i].core;
+    for (int i = 0; i < t->n; i++)
+        if (t->cpus[i].core == core && t->cpus[i].smt == smt) return t->cpus[i].cpu;
+    return -1;
+}
+
+static inline void topo_print(const struct topology* t, FILE* out) {
+    fprintf(out, "cpu,package,core,smt,l2,l3\n");
+    for (int i = 0; i < t->n; i++) {
+        const struct cpu_info* c = &t->cpus[i];
+        fprintf(out, "%d,%d,%d,%d,%d,%d\n", c->cpu, c->package, c->core & 65535, c->smt, c->l2, c->l3);
+    }
+}
+
+// Sort keys, most significant first, for each policy:
+//   compact:   package, L3, core, SMT  -> fill siblings and shared caches first
+//   scatter:   SMT, core rank within its L3, L3, package -> spread across
+//              packages and L3 domains before doubling up anywhere
+//   smt_avoid: SMT, package, L3, core  -> one thread per physical core, kept
+//              close together, siblings only once every core is busy
+static const struct topology* topo_sort_t;
+static enum placement topo_sort_p;
+
+static inline int topo_core_rank(const struct topology* t, const struct cpu_info* c) {
+    int r = 0;
+    for (int i = 0; i < t->n; i++)
+        if (t->cpus[i].smt == 0 && t->cpus[i].l3 == c->l3 && t->cpus[i].package == c->package &&
+            t->cpus[i].core < c->core) r++;
+    return r;
+}
+
+static inline void topo_key(const struct cpu_info* c, int k[4]) {
+    if (topo_sort_p == PLACE_COMPACT) {
+        k[0] = c->package; k[1] = c->l3; k[2] = c->core; k[3] = c->smt;
+    } else if (topo_sort_p == PLACE_SCATTER) {
+        k[0] = c->smt; k[1] = topo_core_rank(topo_sort_t, c); k[2] = c->l3; k[3] = c->package;
+    } else {
+        k[0] = c->smt; k[1] = c->package; k[2] = c->l3; k[3] = c->core;
+    }
+}
+
+static inline int topo_cmp(const void* a, const void* b) {
+    const struct cpu_info *x = a, *y = b;
+    int kx[4], ky[4];
+    topo_key(x, kx); topo_key(y, ky);
+    for (int i = 0; i < 4; i++) if (kx[i] != ky[i]) return kx[i] < ky[i] ? -1 : 1;
+    return x->cpu - y->cpu;
+}
+
+// Fills order[0..t->n) with CPU ids in placement order; thread i goes to
+// order[i % t->n]. PLACE_NONE leaves the order as sysfs lists it.
+static inline void topo_order(const struct topology* t, enum placement p, int* order) {
+    struct cpu_info* tmp = malloc(t->n * sizeof(*tmp));
+    memcpy(tmp, t->cpus, t->n * sizeof(*tmp));
+    if (p != PLACE_NONE) {
+        topo_sort_t = t; topo_sort_p = p;
+        qsort(tmp, t->n, sizeof(*tmp), topo_cmp);
+    }
+    for (int i = 0; i < t->n; i++) order[i] = tmp[i].cpu;
+    free(tmp);
+}
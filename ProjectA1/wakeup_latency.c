@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "topology.h"
+
+#define ROUNDS 20000     // timed round trips per configuration
+#define WARMUP 1000
+#define BUDGET_SEC 2.0   // cap per configuration (spinning on one core is slow)
+
+enum prim { P_PIPE, P_EVENTFD, P_FUTEX, P_CONDVAR, P_YIELD, P_SPIN };
+static const char* prim_names[] = {"pipe", "eventfd", "futex", "condvar", "yield_spin", "spin"};
+
+// One-directional notification; a ping-pong uses one per direction
+struct event {
+    enum prim kind;
+    int fds[2];          // pipe
+    int efd;             // eventfd
+    int word;            // futex / spin flag
+    pthread_mutex_t mu;  // condvar
+    pthread_cond_t cv;
+} __attribute__((aligned(64)));
+
+static struct event ev_ab, ev_ba;
+static volatile int stop;
+
+double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void ev_init(struct event* e, enum prim kind) {
+    memset(e, 0, sizeof(*e));
+    e->kind = kind;
+    if (kind == P_PIPE) pipe(e->fds);
+    if (kind == P_EVENTFD) e->efd = eventfd(0, 0);
+    if (kind == P_CONDVAR) { pthread_mutex_init(&e->mu, NULL); pthread_cond_init(&e->cv, NULL); }
+}
+
+void ev_destroy(struct event* e) {
+    if (e->kind == P_PIPE) { close(e->fds[0]); close(e->fds[1]); }
+    if (e->kind == P_EVENTFD) close(e->efd);
+    if (e->kind == P_CONDVAR) { pthread_mutex_destroy(&e->mu); pthread_cond_destroy(&e->cv); }
+}
+
+void ev_signal(struct event* e) {
+    char c = 1; uint64_t one = 1;
+    switch (e->kind) {
+    case P_PIPE: write(e->fds[1], &c, 1); break;
+    case P_EVENTFD: write(e->efd, &one, sizeof(one)); break;
+    case P_FUTEX:
+        __atomic_store_n(&e->word, 1, __ATOMIC_RELEASE);
+        syscall(SYS_futex, &e->word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        break;
+    case P_CONDVAR:
+        pthread_mutex_lock(&e->mu);
+        e->word = 1;
+        pthread_cond_signal(&e->cv);
+        pthread_mutex_unlock(&e->mu);
+        break;
+    case P_YIELD:
+    case P_SPIN: __atomic_store_n(&e->word, 1, __ATOMIC_RELEASE); break;
+    }
+}
+
+void ev_wait(struct event* e) {
+    char c; uint64_t v;
+    switch (e->kind) {
+    case P_PIPE: read(e->fds[0], &c, 1); break;
+    case P_EVENTFD: read(e->efd, &v, sizeof(v)); break;
+    case P_FUTEX:
+        while (!__atomic_exchange_n(&e->word, 0, __ATOMIC_ACQUIRE))
+            syscall(SYS_futex, &e->word, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+        break;
+    case P_CONDVAR:
+        pthread_mutex_lock(&e->mu);
+        while (!e->word) pthread_cond_wait(&e->cv, &e->mu);
+        e->word = 0;
+        pthread_mutex_unlock(&e->mu);
+        break;
+    case P_YIELD:
+        while (!__atomic_exchange_n(&e->word, 0, __ATOMIC_ACQUIRE)) sched_yield();
+        break;
+    case P_SPIN:
+        while (!__atomic_exchange_n(&e->word, 0, __ATOMIC_ACQUIRE)) __builtin_ia32_pause();
+        break;
+    }
+}
+
+void pin_self(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+void* pong(void* arg) {
+    pin_self((int)(long)arg);
+    for (;;) {
+        ev_wait(&ev_ab);
+        if (stop) break;
+        ev_signal(&ev_ba);
+    }
+    return NULL;
+}
+
+int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Ping-pong between cpu_a and cpu_b; prints <prim>_<placement>,Time_s,P50_us,P99_us,P999_us
+void run(enum prim p, const char* placement, int cpu_a, int cpu_b) {
+    static double lat[ROUNDS];
+    ev_init(&ev_ab, p);
+    ev_init(&ev_ba, p);
+    stop = 0;
+    pthread_t th;
+    pthread_create(&th, NULL, pong, (void*)(long)cpu_b);
+    pin_self(cpu_a);
+
+    double start = now_sec();
+    for (int i = 0; i < WARMUP && now_sec() - start < BUDGET_SEC / 10; i++) {
+        ev_signal(&ev_ab);
+        ev_wait(&ev_ba);
+    }
+    int n = 0;
+    start = now_sec();
+    while (n < ROUNDS && (n % 64 || now_sec() - start < BUDGET_SEC)) {
+        double t0 = now_sec();
+        ev_signal(&ev_ab);
+        ev_wait(&ev_ba);
+        lat[n++] = (now_sec() - t0) * 1e6;
+    }
+    double total = now_sec() - start;
+    stop = 1;
+    ev_signal(&ev_ab);
+    pthread_join(th, NULL);
+    ev_destroy(&ev_ab);
+    ev_destroy(&ev_ba);
+
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("%s_%s,%.3f,%.2f,%.2f,%.2f\n", prim_names[p], placement, total,
+           lat[n / 2], lat[(int)(n * 0.99)], lat[(int)(n * 0.999)]);
+    fflush(stdout);
+}
+
+int main() {
+    static struct topology topo;
+    topo_read(&topo);
+
+    // Same logical CPU, SMT sibling of it, and a CPU on another physical core
+    int base = topo.cpus[0].cpu, sibling = -1, other = -1;
+    for (int i = 0; i < topo.n && sibling < 0; i++)
+        if (topo.cpus[i].smt == 0 && topo_sibling(&topo, topo.cpus[i].cpu, 1) >= 0) {
+            base = topo.cpus[i].cpu;
+            sibling = topo_sibling(&topo, base, 1);
+        }
+    for (int i = 0; i < topo.n; i++)
+        if (topo.cpus[i].smt == 0 && topo.cpus[i].cpu != base) { other = topo.cpus[i].cpu; break; }
+    if (sibling < 0) fprintf(stderr, "No SMT sibling pair found, skipping smt_sibling\n");
+    if (other < 0) fprintf(stderr, "Only one physical core, skipping cross_core\n");
+
+    for (int p = P_PIPE; p <= P_SPIN; p++) {
+        run(p, "same_core", base, base);
+        if (sibling >= 0) run(p, "smt_sibling", base, sibling);
+        if (other >= 0) run(p, "cross_core", base, other);
+    }
+    return 0;
+}
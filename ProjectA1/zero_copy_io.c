@@ -5,19 +5,46 @@
 #include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <poll.h>
+#include <errno.h>
 #include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
 #define FILE_SIZE (100 * 1024 * 1024) // 100 MB
 
+enum sink_kind { SINK_NONE, SINK_UNIX, SINK_TCP };
+
+static char* map; // whole source file, for the mmap-based paths
+static long zc_copied; // MSG_ZEROCOPY completions where the kernel fell back to copying
+
 double now_sec() {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
+// user + system CPU time of the whole process (sender and drain thread)
+double cpu_sec() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
 void make_file(const char* f) {
     int fd = open(f, O_CREAT | O_WRONLY | O_TRUNC, 0644);
     char buf[4096]; memset(buf, 'A', sizeof(buf));
@@ -27,37 +54,234 @@ void make_file(const char* f) {
 }
 
 void* drain(void* arg){
-    int s = *(int*)arg; char buf[4096];
+    int s = *(int*)arg; char buf[65536];
     while (read(s, buf, sizeof(buf)) > 0);
     return NULL;
 }
 
+// Receiving end of the socket paths: a thread that reads and discards
+struct sink { int tx, rx; pthread_t th; };
+
+int sink_open(struct sink* s, enum sink_kind kind) {
+    if (kind == SINK_UNIX) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) return -1;
+        s->tx = sv[0]; s->rx = sv[1];
+    } else {
+        struct sockaddr_in a; memset(&a, 0, sizeof(a));
+        a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(a);
+        int ls = socket(AF_INET, SOCK_STREAM, 0);
+        if (bind(ls, (struct sockaddr*)&a, len) || listen(ls, 1) ||
+            getsockname(ls, (struct sockaddr*)&a, &len)) { close(ls); return -1; }
+        s->tx = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(s->tx, (struct sockaddr*)&a, len)) { close(ls); return -1; }
+        s->rx = accept(ls, NULL, NULL);
+        close(ls);
+    }
+    pthread_create(&s->th, NULL, drain, &s->rx);
+    return 0;
+}
+
+void sink_close(struct sink* s) {
+    shutdown(s->tx, SHUT_WR);
+    pthread_join(s->th, NULL);
+    close(s->tx); close(s->rx);
+}
+
+int write_all(int out, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(out, p, n);
+        if (w <= 0) return -1;
+        p += w; n -= w;
+    }
+    return 0;
+}
+
+size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+
+// -------------------------------
+// Transfer paths: move FILE_SIZE bytes from fd to out in `chunk`-sized calls
+// -------------------------------
+int xfer_read(int fd, int out, size_t chunk) {
+    char* buf = malloc(chunk);
+    while (read(fd, buf, chunk) > 0);
+    free(buf);
+    return 0;
+}
+
+int xfer_read_write(int fd, int out, size_t chunk) {
+    char* buf = malloc(chunk); ssize_t n; int rc = 0;
+    while ((n = read(fd, buf, chunk)) > 0)
+        if ((rc = write_all(out, buf, n))) break;
+    free(buf);
+    return rc;
+}
+
+int xfer_mmap_write(int fd, int out, size_t chunk) {
+    for (size_t off = 0; off < FILE_SIZE; off += chunk)
+        if (write_all(out, map + off, min_sz(chunk, FILE_SIZE - off))) return -1;
+    return 0;
+}
+
+int xfer_sendfile(int fd, int out, size_t chunk) {
+    off_t off = 0;
+    while (off < FILE_SIZE)
+        if (sendfile(out, fd, &off, chunk) <= 0) return -1;
+    return 0;
+}
+
+// pipe sized to the chunk so each splice moves up to one chunk of page references
+int make_pipe(int p[2], size_t chunk) {
+    if (pipe(p)) return -1;
+    fcntl(p[1], F_SETPIPE_SZ, chunk);
+    return 0;
+}
+
+int splice_out(int pin, int out, ssize_t n) {
+    while (n > 0) {
+        ssize_t m = splice(pin, NULL, out, NULL, n, SPLICE_F_MOVE);
+        if (m <= 0) return -1;
+        n -= m;
+    }
+    return 0;
+}
+
+int xfer_splice(int fd, int out, size_t chunk) {
+    int p[2], rc = 0; loff_t off = 0;
+    if (make_pipe(p, chunk)) return -1;
+    while (off < FILE_SIZE && !rc) {
+        ssize_t n = splice(fd, &off, p[1], NULL, chunk, SPLICE_F_MOVE);
+        rc = n <= 0 ? -1 : splice_out(p[0], out, n);
+    }
+    close(p[0]); close(p[1]);
+    return rc;
+}
+
+int xfer_vmsplice(int fd, int out, size_t chunk) {
+    int p[2], rc = 0; size_t off = 0;
+    if (make_pipe(p, chunk)) return -1;
+    while (off < FILE_SIZE && !rc) {
+        struct iovec iov = { map + off, min_sz(chunk, FILE_SIZE - off) };
+        ssize_t n = vmsplice(p[1], &iov, 1, 0);
+        rc = n <= 0 ? -1 : splice_out(p[0], out, n);
+        off += n;
+    }
+    close(p[0]); close(p[1]);
+    return rc;
+}
+
+int xfer_tcp_send(int fd, int out, size_t chunk) {
+    for (size_t off = 0; off < FILE_SIZE; ) {
+        ssize_t n = send(out, map + off, min_sz(chunk, FILE_SIZE - off), 0);
+        if (n <= 0) return -1;
+        off += n;
+    }
+    return 0;
+}
+
+// Read MSG_ZEROCOPY completions off the socket error queue. Each notification
+// covers the inclusive range [ee_info, ee_data] of send() call ids.
+void zc_reap(int s, uint32_t* completed, int block) {
+    if (block) { struct pollfd pfd = { s, 0, 0 }; poll(&pfd, 1, -1); } // POLLERR is always reported
+    char control[128];
+    struct msghdr msg; memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control; msg.msg_controllen = sizeof(control);
+    while (recvmsg(s, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) != -1) {
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err* ee = (struct sock_extended_err*)CMSG_DATA(cm);
+            if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            *completed += ee->ee_data - ee->ee_info + 1;
+            if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) zc_copied++;
+        }
+        msg.msg_controllen = sizeof(control);
+    }
+}
+
+int xfer_msg_zerocopy(int fd, int out, size_t chunk) {
+    int one = 1;
+    if (setsockopt(out, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one))) return -1;
+    uint32_t sent = 0, completed = 0;
+    for (size_t off = 0; off < FILE_SIZE; ) {
+        ssize_t n = send(out, map + off, min_sz(chunk, FILE_SIZE - off), MSG_ZEROCOPY);
+        if (n < 0) {
+            // too many pages pinned (optmem limit): wait for completions, retry
+            if (errno != ENOBUFS || completed == sent) return -1;
+            zc_reap(out, &completed, 1);
+            continue;
+        }
+        off += n; sent++;
+        zc_reap(out, &completed, 0);
+    }
+    // pages must stay untouched until every send is acknowledged
+    while (completed < sent) zc_reap(out, &completed, 1);
+    return 0;
+}
+
+int xfer_copy_file_range(int fd, int out, size_t chunk) {
+    int dst = open("testfile_copy.dat", O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    loff_t in_off = 0, out_off = 0; int rc = 0;
+    while (in_off < FILE_SIZE)
+        if (copy_file_range(fd, &in_off, dst, &out_off, chunk, 0) <= 0) { rc = -1; break; }
+    close(dst);
+    unlink("testfile_copy.dat");
+    return rc;
+}
+
+struct method {
+    const char* name;
+    int (*xfer)(int fd, int out, size_t chunk);
+    enum sink_kind sink;
+};
+
 int main() {
     const char* f = "testfile.dat";
     make_file(f);
-    struct stat st;
     int fd = open(f, O_RDONLY);
-    fstat(fd, &st);
+    map = mmap(NULL, FILE_SIZE, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
     close(fd);
 
-    // Regular read
-    fd = open(f, O_RDONLY);
-    char buf[4096]; double t0 = now_sec();
-    while (read(fd, buf, sizeof(buf)) > 0);
-    double t1 = now_sec();
-    printf("regular_read,%.3f\n", t1 - t0);
-    close(fd);
+    struct method methods[] = {
+        {"regular_read",    xfer_read,            SINK_NONE},
+        {"read_write",      xfer_read_write,      SINK_UNIX},
+        {"mmap_write",      xfer_mmap_write,      SINK_UNIX},
+        {"sendfile",        xfer_sendfile,        SINK_UNIX},
+        {"splice",          xfer_splice,          SINK_UNIX},
+        {"vmsplice",        xfer_vmsplice,        SINK_UNIX},
+        {"tcp_send",        xfer_tcp_send,        SINK_TCP},
+        {"msg_zerocopy",    xfer_msg_zerocopy,    SINK_TCP},
+        {"copy_file_range", xfer_copy_file_range, SINK_NONE},
+    };
+    size_t chunks[] = {4096, 65536, 1 << 20};
 
-    // Zero-copy sendfile
-    int sv[2]; socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
-    pthread_t dr; pthread_create(&dr, NULL, drain, &sv[1]);
-    fd = open(f, O_RDONLY); off_t off = 0;
-    t0 = now_sec();
-    sendfile(sv[0], fd, &off, st.st_size);
-    t1 = now_sec();
-    printf("sendfile,%.3f\n", t1 - t0);
-    shutdown(sv[0], SHUT_WR);
-    pthread_join(dr, NULL);
-    close(fd); close(sv[0]); close(sv[1]);
+    // Mode,Time_s,GBps,CPU_s_per_GB
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            struct sink s = { -1, -1 };
+            if (methods[m].sink != SINK_NONE && sink_open(&s, methods[m].sink)) {
+                fprintf(stderr, "%s: sink setup failed\n", methods[m].name);
+                continue;
+            }
+            fd = open(f, O_RDONLY);
+            zc_copied = 0;
+            double c0 = cpu_sec(), t0 = now_sec();
+            int rc = methods[m].xfer(fd, s.tx, chunks[c]);
+            if (methods[m].sink != SINK_NONE) sink_close(&s); // include the receiver draining
+            double t1 = now_sec(), c1 = cpu_sec();
+            close(fd);
+            if (rc) {
+                fprintf(stderr, "%s: %s\n", methods[m].name, strerror(errno));
+                continue;
+            }
+            double gb = FILE_SIZE / 1e9;
+            printf("%s_%zu%s,%.3f,%.3f,%.3f\n", methods[m].name,
+                   chunks[c] >= (1 << 20) ? chunks[c] >> 20 : chunks[c] >> 10,
+                   chunks[c] >= (1 << 20) ? "M" : "K",
+                   t1 - t0, gb / (t1 - t0), (c1 - c0) / gb);
+            if (zc_copied) fprintf(stderr, "%s: %ld completions were copied, not zero-copy\n",
+                                   methods[m].name, zc_copied);
+        }
+    }
+    munmap(map, FILE_SIZE);
     return 0;
 }
@@ -1,4 +1,8 @@
 // benchmark.cpp
+// Usage: ./benchmark [default|quotient|quick]
+// Each configuration sweeps filter type, set size, target FPR (Bloom) or
+// fingerprint bits (everything else), load factor (dynamic filters) and
+// thread count, and every one of those parameters is applied to the filter.
 #include <bits/stdc++.h>
 #include "filters.cpp"
 #include <thread>
@@ -8,19 +12,69 @@
 #include <filesystem>
 using namespace std;
 
-struct Result {
-    string filter;
-    size_t n;
-    double fpr_target;
-    string workload;
-    double neg_share;
-    double load_factor;
-    int threads;
-    int fp_bits;
-    double insert_s, query_s, false_pos_rate;
-    double bpe;
+struct Config {
+    string name;
+    vector<string> filters;
+    vector<size_t> sizes;
+    vector<double> fprs;      // Bloom filters
+    vector<int> fp_bits;      // fingerprint filters
+    vector<double> load_factors;
+    vector<int> threads;
+    vector<string> workloads; // mixed phases on dynamic filters
+    vector<double> neg_shares;
+    string lookup_csv, workload_csv;
+    bool scaling;             // also run the shared-filter scaling pass
+    vector<string> range_filters = {};  // query_range() pass; point filters for comparison
+    vector<uint64_t> range_widths = {};
+    string range_csv = "";
+    vector<string> growth_filters = {}; // grown from GROWTH_START keys; compared to their static version
+    string growth_csv = "";
 };
 
+vector<Config> configs() {
+    Config all{"default",
+               {"bloom", "bloom_blocked", "xor", "fuse3", "cuckoo", "cuckoo_mt", "quotient"},
+               {1'000'000, 10'000'000},
+               {0.05, 0.01, 0.001},
+               {8, 12, 16},
+               {0.5, 0.75, 0.9, 0.95},
+               {1, 2, 4, 8},
+               {"read-mostly", "balanced"},
+               {0.0, 0.5, 0.9},
+               "results/all_results.csv", "results/workload_results.csv", true};
+    all.range_filters = {"range", "bloom_blocked", "cuckoo"};
+    all.range_widths = {1, 16, 256, 4096, 65536, 1 << 20};
+    all.range_csv = "results/range_results.csv";
+    all.growth_filters = {"cuckoo_grow", "quotient_grow"};
+    all.growth_csv = "results/growth_results.csv";
+    Config quotient = all;
+    quotient.name = "quotient";
+    quotient.filters = {"quotient"};
+    quotient.sizes = {1'000'000, 5'000'000};
+    quotient.fp_bits = {8, 16};
+    quotient.load_factors = {0.6, 0.8, 0.95};
+    quotient.threads = {1, 4};
+    quotient.lookup_csv = "results/quotient_results.csv";
+    quotient.workload_csv = "results/quotient_workload_results.csv";
+    quotient.scaling = false;
+    quotient.range_filters = {};
+    quotient.growth_filters = {};
+    Config quick = all;
+    quick.name = "quick";
+    quick.sizes = {200'000};
+    quick.fprs = {0.01};
+    quick.fp_bits = {8, 16};
+    quick.load_factors = {0.5, 0.95};
+    quick.threads = {1, 2};
+    quick.neg_shares = {0.5};
+    quick.lookup_csv = "results/quick_results.csv";
+    quick.workload_csv = "results/quick_workload_results.csv";
+    quick.scaling = false;
+    quick.range_csv = "results/quick_range_results.csv";
+    quick.growth_csv = "results/quick_growth_results.csv";
+    return {all, quotient, quick};
+}
+
 vector<uint64_t> generate_keys(size_t n, uint64_t seed = 1) {
     vector<uint64_t> v(n);
     mt19937_64 rng(seed);
@@ -28,120 +82,457 @@ vector<uint64_t> generate_keys(size_t n, uint64_t seed = 1) {
     return v;
 }
 
-void run_workload(Filter *f, const vector<uint64_t>& keys,
-                  const vector<uint64_t>& neg_keys,
-                  string workload, double neg_share,
-                  Result &r) {
+// Runs work(lo, hi) on `threads` threads over an even split of [0, n);
+// returns the seconds from the common start until the last thread ends
+template <typename Work>
+double run_parallel(int threads, size_t n, Work work) {
+    atomic<int> ready{0};
+    atomic<bool> go{false};
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back([&, t] {
+            ready++;
+            while (!go.load(memory_order_acquire)) this_thread::yield();
+            work(n * t / threads, n * (t + 1) / threads);
+        });
+    while (ready.load() < threads) this_thread::yield();
+    auto t0 = chrono::high_resolution_clock::now();
+    go.store(true, memory_order_release);
+    for (auto& th : pool) th.join();
+    return chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count();
+}
+
+// ================================================================
+// Point lookups: positive and negative keys measured separately
+// ================================================================
+struct LookupStats {
+    double ns;              // wall time per op per thread, from query_batch
+    double p50, p99, p999;  // per-op latency of query(), timer cost removed
+    size_t hits;
+};
+
+// Cost of one steady_clock::now() pair, subtracted from every sample
+double timer_overhead_ns() {
+    vector<double> d(10001);
+    for (auto& x : d) {
+        auto t0 = chrono::steady_clock::now();
+        auto t1 = chrono::steady_clock::now();
+        x = chrono::duration<double, nano>(t1 - t0).count();
+    }
+    nth_element(d.begin(), d.begin() + d.size() / 2, d.end());
+    return d[d.size() / 2];
+}
+
+double percentile(vector<float>& v, double p) {
+    size_t i = min(v.size() - 1, (size_t)(p * v.size()));
+    nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+LookupStats measure_lookups(Filter* f, const vector<uint64_t>& q, int threads, double overhead) {
+    LookupStats s{};
+    atomic<size_t> hits{0};
+    double t = run_parallel(threads, q.size(), [&](size_t lo, size_t hi) {
+        uint8_t out[4096];
+        size_t h = 0;
+        for (size_t i = lo; i < hi; i += sizeof(out)) {
+            size_t m = min(sizeof(out), hi - i);
+            f->query_batch(q.data() + i, m, out);
+            for (size_t j = 0; j < m; j++) h += out[j];
+        }
+        hits += h;
+    });
+    s.ns = t * 1e9 * threads / q.size();
+    s.hits = hits;
+
+    // latency pass: every query() timed on its own, all threads at once
+    vector<float> samples(q.size());
+    run_parallel(threads, q.size(), [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            auto t0 = chrono::steady_clock::now();
+            bool r = f->query(q[i]);
+            auto t1 = chrono::steady_clock::now();
+            asm volatile("" : : "r"(r));
+            samples[i] = (float)max(0.0, chrono::duration<double, nano>(t1 - t0).count() - overhead);
+        }
+    });
+    s.p50 = percentile(samples, 0.5);
+    s.p99 = percentile(samples, 0.99);
+    s.p999 = percentile(samples, 0.999);
+    return s;
+}
+
+// ================================================================
+// Mixed phase on a loaded dynamic filter: an update removes an old key
+// and inserts a fresh one, so the load factor stays where it was.
+// Updates are undone afterwards (untimed) to restore the key set.
+// ================================================================
+struct MixedStats { double ns; size_t false_neg; bool failed; };
+
+MixedStats run_mixed(Filter* f, const vector<uint64_t>& keys, size_t count,
+                     const vector<uint64_t>& neg_keys, int update_pct, double neg_share, int threads) {
+    size_t half = count / 2; // updates remove from the first half, positives come from the second
+    size_t ops = min<size_t>(half, 1'000'000);
+    auto fresh = [](size_t i) { return hash64(i, 0xf7e5); };
+    auto is_update = [&](size_t i) { return (int)(mix64(i) % 100) < update_pct; };
+    atomic<size_t> false_neg{0};
+    atomic<bool> failed{false}; // an insert found no room (cuckoo stash full)
+    double t = run_parallel(threads, ops, [&](size_t lo, size_t hi) {
+        size_t fn = 0;
+        try {
+            for (size_t i = lo; i < hi; i++) {
+                if (is_update(i)) {
+                    f->remove(keys[i]);
+                    f->insert(fresh(i));
+                } else if ((mix64(i ^ 0x5eed) % 1000) < neg_share * 1000) {
+                    asm volatile("" : : "r"(f->query(neg_keys[i])));
+                } else {
+                    fn += !f->query(keys[half + mix64(i) % (count - half)]);
+                }
+            }
+        } catch (const exception&) {
+            failed = true;
+        }
+        false_neg += fn;
+    });
+    if (failed) return {0, 0, true};
+    for (size_t i = 0; i < ops; i++)
+        if (is_update(i)) { f->remove(fresh(i)); f->insert(keys[i]); }
+    return {t * 1e9 * threads / ops, false_neg, false};
+}
+
+// ================================================================
+// Shared-filter scaling pass
+// ================================================================
+struct ScalingResult {
+    string filter;
+    size_t n;
+    int threads;
+    double insert_mops, query_mops; // insert_mops < 0: built on one thread
+};
+
+// One shared filter per thread count. Concurrent filters are filled by all
+// threads at once; the others are built on one thread. Every filter is then
+// queried by all threads (half positive, half negative keys, query_batch).
+ScalingResult run_scaling(const string& ftype, const vector<uint64_t>& keys,
+                          const vector<uint64_t>& mix, int threads) {
     size_t n = keys.size();
-    size_t inserts = 0, queries = 0, fp = 0, negs = 0;
+    ScalingResult r{ftype, n, threads, -1, 0};
+    unique_ptr<Filter> f(make_filter(ftype, n, 0.01));
+    if (f->concurrent()) {
+        double t = run_parallel(threads, n, [&](size_t lo, size_t hi) {
+            f->insert_batch(keys.data() + lo, hi - lo);
+        });
+        r.insert_mops = n / t / 1e6;
+    } else {
+        f->build(keys);
+    }
+    atomic<size_t> hits{0};
+    double t = run_parallel(threads, mix.size(), [&](size_t lo, size_t hi) {
+        vector<uint8_t> out(4096);
+        size_t h = 0;
+        for (size_t i = lo; i < hi; i += out.size()) {
+            size_t m = min(out.size(), hi - i);
+            f->query_batch(mix.data() + i, m, out.data());
+            for (size_t j = 0; j < m; j++) h += out[j];
+        }
+        hits += h;
+    });
+    r.query_mops = mix.size() / t / 1e6;
+    if (hits < mix.size() / 2) cerr << "⚠️ " << ftype << ": false negatives under " << threads << " threads\n";
+    return r;
+}
 
-    auto start = chrono::high_resolution_clock::now();
+void run_scaling_pass(const vector<int>& threads) {
+    vector<string> scaling_filters = {"bloom_blocked_mt", "bloom_sectorized_mt", "cuckoo_mt",
+                                      "bloom_blocked", "xor", "fuse3", "cuckoo", "quotient"};
+    vector<int> scaling_threads = threads;
+    int hw = (int)thread::hardware_concurrency();
+    if (hw > scaling_threads.back()) scaling_threads.push_back(hw);
+    size_t scaling_n = 10'000'000;
+    auto keys = generate_keys(scaling_n, 42), neg_keys = generate_keys(scaling_n, 999);
+    vector<uint64_t> mix(scaling_n);
+    for (size_t i = 0; i < scaling_n; i++) mix[i] = i % 2 ? neg_keys[i] : keys[i];
 
-    if (workload == "read-only") {
-        for (size_t i = 0; i < n; i++) {
-            uint64_t k = (i % 100 < neg_share * 100) ? neg_keys[i] : keys[i];
-            bool res = f->query(k);
-            if (res && i % 100 < neg_share * 100) fp++;
-            queries++;
+    ofstream sout("results/scaling_results.csv");
+    sout << "Filter,N,Threads,Insert_Mops,Query_Mops,Insert_Speedup,Query_Speedup\n";
+    for (auto& ftype : scaling_filters) {
+        ScalingResult base{};
+        for (auto tcount : scaling_threads) {
+            ScalingResult r = run_scaling(ftype, keys, mix, tcount);
+            if (tcount == scaling_threads.front()) base = r;
+            sout << r.filter << "," << r.n << "," << r.threads << ",";
+            if (r.insert_mops >= 0) sout << r.insert_mops;
+            sout << "," << r.query_mops << ",";
+            if (r.insert_mops >= 0) sout << r.insert_mops / base.insert_mops;
+            sout << "," << r.query_mops / base.query_mops << "\n";
+            cerr << "✅ scaling " << ftype << " threads=" << tcount << " insert=" << r.insert_mops
+                 << " query=" << r.query_mops << " Mops/s\n";
         }
-    } else if (workload == "balanced") {
-        for (size_t i = 0; i < n; i++) {
-            if (i % 2 == 0) f->insert(keys[i]);
-            else {
-                uint64_t k = (i % 100 < neg_share * 100) ? neg_keys[i] : keys[i];
-                bool res = f->query(k);
-                if (res && i % 100 < neg_share * 100) fp++;
-                queries++;
+    }
+    cout << "✅ Results saved to results/scaling_results.csv\n";
+}
+
+// ================================================================
+// Range queries: FPR over empty ranges and ns per query, by width.
+// Point filters probe each key of ranges up to Filter::RANGE_PROBES
+// wide and cannot prune wider ones.
+// ================================================================
+void run_range_pass(const Config& cfg) {
+    ofstream out(cfg.range_csv);
+    out << "Filter,N,Width,BPE,RangeFPR,Empty_ns,NonEmpty_ns,FalseNegatives\n";
+    const size_t Q = 200'000;
+    for (auto n : cfg.sizes) {
+        auto keys = generate_keys(n, 42);
+        auto sorted_keys = keys;
+        sort(sorted_keys.begin(), sorted_keys.end());
+        for (auto& ftype : cfg.range_filters) {
+            unique_ptr<Filter> f(make_filter(ftype, n, 0.01));
+            f->build(keys);
+            double bpe = 8.0 * f->size_bytes() / n;
+            for (auto w : cfg.range_widths) {
+                // empty ranges [lo, lo + w - 1], and ranges covering a stored key
+                mt19937_64 rng(7);
+                vector<uint64_t> empty_lo, hit_lo;
+                while (empty_lo.size() < Q) {
+                    uint64_t lo = rng();
+                    if (lo + (w - 1) < lo) continue;
+                    auto it = lower_bound(sorted_keys.begin(), sorted_keys.end(), lo);
+                    if (it == sorted_keys.end() || *it > lo + (w - 1)) empty_lo.push_back(lo);
+                }
+                for (size_t i = 0; i < Q; i++) {
+                    uint64_t k = keys[rng() % n], off = min<uint64_t>(k, rng() % w);
+                    hit_lo.push_back(min<uint64_t>(k - off, ~0ULL - (w - 1)));
+                }
+
+                size_t fp = 0, fn = 0;
+                auto t0 = chrono::high_resolution_clock::now();
+                for (auto lo : empty_lo) fp += f->query_range(lo, lo + (w - 1));
+                auto t1 = chrono::high_resolution_clock::now();
+                for (auto lo : hit_lo) fn += !f->query_range(lo, lo + (w - 1));
+                auto t2 = chrono::high_resolution_clock::now();
+                double empty_ns = chrono::duration<double, nano>(t1 - t0).count() / Q;
+                double hit_ns = chrono::duration<double, nano>(t2 - t1).count() / Q;
+                out << ftype << "," << n << "," << w << "," << bpe << "," << (double)fp / Q << ","
+                    << empty_ns << "," << hit_ns << "," << fn << "\n";
+                cerr << "✅ range " << ftype << " n=" << n << " width=" << w << " fpr=" << (double)fp / Q
+                     << " empty=" << empty_ns << "ns\n";
+                if (fn) cerr << "⚠️ " << ftype << ": " << fn << " ranges with a key answered empty\n";
             }
         }
-    } else if (workload == "read-mostly") {
-        for (size_t i = 0; i < n; i++) {
-            if (i % 20 == 0) f->insert(keys[i]);  // 5% inserts
-            else {
-                uint64_t k = (i % 100 < neg_share * 100) ? neg_keys[i] : keys[i];
-                bool res = f->query(k);
-                if (res && i % 100 < neg_share * 100) fp++;
-                queries++;
+    }
+    cout << "✅ Results saved to " << cfg.range_csv << "\n";
+}
+
+// ================================================================
+// Growth: a growing filter sized for GROWTH_START keys is filled to the
+// largest set size. Every half doubling its bits/entry and FPR are set
+// against a static filter built for that many keys with the fingerprint
+// width the growing filter has reached, which isolates the space left
+// empty in its tables; more than twice the static bits/entry on average
+// is flagged.
+// ================================================================
+const size_t GROWTH_START = 1000;
+
+void run_growth_pass(const Config& cfg) {
+    ofstream out(cfg.growth_csv);
+    out << "Filter,FPR_Target,Start,Keys,FPBits,BPE,FalsePosRate,Static_BPE,Static_FalsePosRate\n";
+    size_t n = *max_element(cfg.sizes.begin(), cfg.sizes.end());
+    auto keys = generate_keys(n, 42), neg_keys = generate_keys(200'000, 999);
+    vector<uint8_t> hits(neg_keys.size());
+    auto fp_rate = [&](Filter* f) {
+        f->query_batch(neg_keys.data(), neg_keys.size(), hits.data());
+        return (double)count(hits.begin(), hits.end(), 1) / neg_keys.size();
+    };
+    for (auto& ftype : cfg.growth_filters) {
+        string base = ftype.substr(0, ftype.rfind("_grow"));
+        for (auto fpr : cfg.fprs) {
+            unique_ptr<Filter> f(make_filter(ftype, GROWTH_START, fpr));
+            double ratio_sum = 0;
+            int points = 0;
+            size_t done = 0;
+            for (int step = 1; done < n; step++) {
+                size_t target = min(n, (size_t)(GROWTH_START * pow(2.0, step / 2.0)));
+                f->insert_batch(keys.data() + done, target - done);
+                done = target;
+                unique_ptr<Filter> s(make_filter(base, done, fpr, f->fingerprint_bits()));
+                s->insert_batch(keys.data(), done);
+                double bpe = 8.0 * f->size_bytes() / done, static_bpe = 8.0 * s->size_bytes() / done;
+                double rate = fp_rate(f.get()), static_rate = fp_rate(s.get());
+                ratio_sum += bpe / static_bpe;
+                points++;
+                out << ftype << "," << fpr << "," << GROWTH_START << "," << done << "," << f->fingerprint_bits()
+                    << "," << bpe << "," << rate << "," << static_bpe << "," << static_rate << "\n";
             }
+            double ratio = ratio_sum / points;
+            cerr << "✅ growth " << ftype << " fpr=" << fpr << " keys=" << done << " bits=" << f->fingerprint_bits()
+                 << " bpe=" << 8.0 * f->size_bytes() / done << " (" << ratio << "x static on average) fpr_measured="
+                 << fp_rate(f.get()) << "\n";
+            if (ratio > 2) cerr << "⚠️ " << ftype << ": " << ratio << "x the bits/entry of a static " << base << "\n";
         }
     }
+    cout << "✅ Results saved to " << cfg.growth_csv << "\n";
+}
 
-    auto end = chrono::high_resolution_clock::now();
-    double elapsed = chrono::duration<double>(end - start).count();
-    r.query_s = elapsed;
-    r.false_pos_rate = (double)fp / (queries ? queries : 1);
+// ================================================================
+// Save/open round trip: every filter with an on-disk format is saved,
+// reopened from the mapped file and must answer every query as before.
+// ================================================================
+void run_format_check() {
+    vector<string> types = {"bloom", "bloom_blocked", "bloom_sectorized", "bloom_register", "xor", "fuse3",
+                            "fuse4", "cuckoo", "cuckoo2", "cuckoo8", "cuckoo_ss", "cuckoo_mt", "quotient",
+                            "quotient_grow", "cuckoo_grow"};
+    const size_t n = 100'000;
+    auto keys = generate_keys(n, 42), probe = generate_keys(n, 999);
+    probe.insert(probe.end(), keys.begin(), keys.end());
+    string path = "results/roundtrip.filter";
+    for (auto& ftype : types) {
+        // growing filters start small, so the saved one has grown
+        bool growing = ftype.size() > 5 && ftype.compare(ftype.size() - 5, 5, "_grow") == 0;
+        unique_ptr<Filter> f(make_filter(ftype, growing ? 1000 : n, 0.01));
+        f->build(keys);
+        vector<uint8_t> before(probe.size()), after(probe.size());
+        f->query_batch(probe.data(), probe.size(), before.data());
+        try {
+            save_filter(*f, path);
+            unique_ptr<Filter> g(open_filter(path, true));
+            g->query_batch(probe.data(), probe.size(), after.data());
+            size_t diff = 0;
+            for (size_t i = 0; i < probe.size(); i++) diff += before[i] != after[i];
+            if (diff) cerr << "⚠️ round trip " << ftype << ": " << diff << " answers changed\n";
+            else cerr << "✅ round trip " << ftype << " (" << filesystem::file_size(path) << " bytes)\n";
+        } catch (const exception& e) {
+            cerr << "⚠️ round trip " << ftype << ": " << e.what() << "\n";
+        }
+    }
+    filesystem::remove(path);
 }
 
-int main() {
+// ================================================================
+// Main sweep
+// ================================================================
+int main(int argc, char** argv) {
+    string name = argc > 1 ? argv[1] : "default";
+    auto all = configs();
+    auto it = find_if(all.begin(), all.end(), [&](const Config& c) { return c.name == name; });
+    if (it == all.end()) {
+        cerr << "usage: " << argv[0] << " [default|quotient|quick]\n";
+        return 1;
+    }
+    const Config& cfg = *it;
     filesystem::create_directory("results");
-    vector<Result> results;
-
-    vector<string> filters = {"quotient"};//"bloom", "xor", "cuckoo",};
-    vector<size_t> sizes = {1'000'000, 5'000'000, 10'000'000};
-    vector<double> fprs = {0.05, 0.01, 0.001};
-    vector<string> workloads = {"read-only", "read-mostly", "balanced"};
-    vector<double> neg_shares = {0.0, 0.5, 0.9};
-    vector<double> load_factors = {0.4, 0.6, 0.8, 0.9, 0.95};
-    vector<int> fp_bits = {8, 12, 16};
-    vector<int> threads = {1, 2, 4, 8};
-
-    for (auto n : sizes) {
-        auto keys = generate_keys(n, 42);
-        auto neg_keys = generate_keys(n, 999);
-
-        for (auto fpr : fprs) {
-            for (auto ftype : filters) {
-                for (auto workload : workloads) {
-                    for (auto neg_share : neg_shares) {
-                        for (auto tcount : threads) {
-                            for (auto bits : fp_bits) {
-                                // Skip irrelevant params
-                                if ((ftype == "xor" || ftype == "cuckoo") && bits == 0) continue;
-                                if ((ftype == "xor" || ftype == "bloom") && workload != "read-only") continue; // static filters
-                                if (ftype == "xor" && fpr != 0.01) continue; // just one config for brevity
-
-                                Result r;
-                                r.filter = ftype;
-                                r.n = n;
-                                r.fpr_target = fpr;
-                                r.workload = workload;
-                                r.neg_share = neg_share;
-                                r.fp_bits = bits;
-                                r.threads = tcount;
-                                r.load_factor = 1.0;
-
-                                unique_ptr<Filter> f(make_filter(ftype, n, fpr));
-                                auto t0 = chrono::high_resolution_clock::now();
-                                for (auto k : keys) f->insert(k);
-                                auto t1 = chrono::high_resolution_clock::now();
-                                r.insert_s = chrono::duration<double>(t1 - t0).count();
-
-                                run_workload(f.get(), keys, neg_keys, workload, neg_share, r);
-
-                                r.bpe = (8.0 * f->size_bytes()) / (double)r.n;
-                                results.push_back(r);
-
-                                cerr << "✅ " << ftype << " n=" << n << " fpr=" << fpr
-                                     << " workload=" << workload << " neg=" << neg_share
-                                     << " bits=" << bits << " threads=" << tcount
-                                     << " done.\n";
+    double overhead = timer_overhead_ns();
+
+    // one row per loaded filter and thread count
+    ofstream out(cfg.lookup_csv);
+    out << "Filter,N,FPR_Target,FPBits,LoadFactor,Threads,Keys,BPE,FalsePosRate,Insert_ns,"
+           "Pos_ns,Pos_p50,Pos_p99,Pos_p999,Neg_ns,Neg_p50,Neg_p99,Neg_p999\n";
+    // one row per mixed phase
+    ofstream wout(cfg.workload_csv);
+    wout << "Filter,N,FPBits,LoadFactor,Threads,Workload,NegShare,Op_ns,Mops,FalseNegatives\n";
+
+    for (auto n : cfg.sizes) {
+        // room for a full table at any load factor; quotient tables are rounded up to a power of two
+        auto keys = generate_keys(n * 9 / 4, 42);
+        auto neg_keys = generate_keys(max<size_t>(n, 1'000'000), 999);
+        vector<uint64_t> neg_q(neg_keys.begin(), neg_keys.begin() + min<size_t>(n, 1'000'000));
+
+        for (auto& ftype : cfg.filters) {
+            bool is_bloom = ftype.rfind("bloom", 0) == 0;
+            bool is_static = is_bloom || ftype == "xor" || ftype.rfind("fuse", 0) == 0;
+            // Bloom filters are sized by target FPR, the others by fingerprint width
+            vector<pair<double, int>> params;
+            if (is_bloom) for (auto fpr : cfg.fprs) params.push_back({fpr, 0});
+            else for (auto bits : cfg.fp_bits) params.push_back({0, bits});
+            set<int> seen_bits; // e.g. XOR has no 12-bit variant; 12 becomes 16
+
+            for (auto [fpr, bits] : params) {
+                if (!is_bloom && !seen_bits.insert(unique_ptr<Filter>(make_filter(ftype, 64, 0.01, bits))->fingerprint_bits()).second)
+                    continue;
+                // static filters hold exactly the keys they are built from
+                vector<double> lfs = is_static ? vector<double>{1.0} : cfg.load_factors;
+                for (auto lf : lfs) {
+                    unique_ptr<Filter> f;
+                    size_t count = 0;
+                    double insert_ns = 0;
+                    for (auto tcount : cfg.threads) {
+                        // a concurrent filter is reloaded by each thread count; others are loaded once
+                        if (!f || f->concurrent()) {
+                            f.reset(make_filter(ftype, n, is_bloom ? fpr : 0.01, bits));
+                            count = is_static || !f->slots() ? n : (size_t)(lf * f->slots());
+                            int load_threads = f->concurrent() ? tcount : 1;
+                            try {
+                                double t;
+                                if (is_static) {
+                                    vector<uint64_t> batch(keys.begin(), keys.begin() + count);
+                                    auto t0 = chrono::high_resolution_clock::now();
+                                    f->build(batch);
+                                    t = chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count();
+                                } else {
+                                    atomic<bool> full{false};
+                                    t = run_parallel(load_threads, count, [&](size_t lo, size_t hi) {
+                                        try {
+                                            f->insert_batch(keys.data() + lo, hi - lo);
+                                        } catch (const exception&) {
+                                            full = true;
+                                        }
+                                    });
+                                    if (full) throw runtime_error("filter full before reaching the load factor");
+                                }
+                                insert_ns = t * 1e9 * load_threads / count;
+                            } catch (const exception& e) {
+                                cerr << "⚠️ " << ftype << " n=" << n << " bits=" << bits << " lf=" << lf
+                                     << ": " << e.what() << "\n";
+                                f.reset();
+                                break;
                             }
                         }
+
+                        size_t q_n = min<size_t>(count, 1'000'000);
+                        vector<uint64_t> pos_q(q_n);
+                        for (size_t i = 0; i < q_n; i++) pos_q[i] = keys[i * count / q_n];
+                        LookupStats pos = measure_lookups(f.get(), pos_q, tcount, overhead);
+                        LookupStats neg = measure_lookups(f.get(), neg_q, tcount, overhead);
+                        if (pos.hits < q_n) cerr << "⚠️ " << ftype << ": " << q_n - pos.hits << " false negatives\n";
+                        double load = f->slots() ? (double)count / f->slots() : 1.0;
+                        double bpe = 8.0 * f->size_bytes() / count;
+                        double fp_rate = (double)neg.hits / neg_q.size();
+
+                        out << ftype << "," << n << "," << fpr << "," << f->fingerprint_bits() << ","
+                            << load << "," << tcount << "," << count << "," << bpe << "," << fp_rate << ","
+                            << insert_ns << "," << pos.ns << "," << pos.p50 << "," << pos.p99 << "," << pos.p999 << ","
+                            << neg.ns << "," << neg.p50 << "," << neg.p99 << "," << neg.p999 << "\n";
+                        cerr << "✅ " << ftype << " n=" << n << " fpr=" << fpr << " bits=" << f->fingerprint_bits()
+                             << " load=" << load << " threads=" << tcount << " bpe=" << bpe << " fpr_measured="
+                             << fp_rate << " pos=" << pos.ns << "ns neg=" << neg.ns << "ns\n";
+
+                        // mixed phases need remove(), and thread-safe updates for more than one thread
+                        if (is_static || (tcount > 1 && !f->concurrent())) continue;
+                        for (auto& workload : cfg.workloads) {
+                            int update_pct = workload == "balanced" ? 50 : 5;
+                            for (auto neg_share : cfg.neg_shares) {
+                                MixedStats m = run_mixed(f.get(), keys, count, neg_keys, update_pct, neg_share, tcount);
+                                if (m.failed) {
+                                    // the key set is no longer known; reload before the next thread count
+                                    cerr << "⚠️ " << ftype << " " << workload << " lf=" << lf << ": filter full\n";
+                                    f.reset();
+                                    break;
+                                }
+                                wout << ftype << "," << n << "," << f->fingerprint_bits() << "," << load << ","
+                                     << tcount << "," << workload << "," << neg_share << "," << m.ns << ","
+                                     << tcount * 1e3 / m.ns << "," << m.false_neg << "\n";
+                            }
+                            if (!f) break;
+                        }
                     }
                 }
             }
         }
     }
+    cout << "✅ Results saved to " << cfg.lookup_csv << " and " << cfg.workload_csv << "\n";
 
-    // Write CSV
-    ofstream out("results/all_results.csv");
-    out << "Filter,N,FPR_Target,Workload,NegShare,LoadFactor,Threads,FPBits,Insert_s,Query_s,FalsePosRate,BPE\n";
-    for (auto &r : results) {
-        out << r.filter << "," << r.n << "," << r.fpr_target << ","
-            << r.workload << "," << r.neg_share << "," << r.load_factor << ","
-            << r.threads << "," << r.fp_bits << ","
-            << r.insert_s << "," << r.query_s << ","
-            << r.false_pos_rate << "," << r.bpe << "\n";
-    }
-    cout << "✅ Results saved to results/all_results.csv\n";
+    if (!cfg.range_filters.empty()) run_range_pass(cfg);
+    if (!cfg.growth_filters.empty()) run_growth_pass(cfg);
+    run_format_check();
+    if (cfg.scaling) run_scaling_pass(cfg.threads);
 }
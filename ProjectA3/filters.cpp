@@ -1,281 +1,1800 @@
 // filters.cpp
 // ECSE 4320 Project A3 — Approximate Membership Filters
-// Implements Blocked Bloom, XOR, Cuckoo, and Quotient Filters
+// Implements Bloom (standard, blocked, sectorized, register-blocked), XOR, Binary Fuse, Cuckoo, and Quotient Filters
 // Author: Vito Salvaggio
 
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "hash.h"
 using namespace std;
 
 // ================================================================
 // Common Interface
 // ================================================================
+// A filter's persistent state: a kind tag, parameters and up to
+// MAX_SECTIONS data sections. image() describes a filter for save_filter(); a filter
+// constructed from an image reads the sections in place (section 6).
+enum FilterKind : uint32_t {
+    KIND_BLOOM = 1, KIND_BLOCKED_BLOOM, KIND_XOR, KIND_FUSE, KIND_CUCKOO, KIND_QUOTIENT,
+    KIND_SCALABLE_CUCKOO,
+};
+
+struct FilterImage {
+    uint32_t kind = 0;
+    uint64_t params[8] = {};
+    static constexpr int MAX_SECTIONS = 64;
+    struct Section { void* data; uint64_t bytes; } sections[MAX_SECTIONS] = {};
+    int n_sections = 0;
+    void add(const void* p, uint64_t bytes) { sections[n_sections++] = {(void*)p, bytes}; }
+};
+
 class Filter {
 public:
     virtual void insert(uint64_t key) = 0;
     virtual bool query(uint64_t key) = 0;
     virtual void remove(uint64_t key) {}
+    // Bulk construction; static filters override this, dynamic ones just insert
+    virtual void build(const vector<uint64_t>& keys) { for (auto k : keys) insert(k); }
     virtual size_t size_bytes() const = 0;
     virtual ~Filter() = default;
+
+    // Fingerprint slots and bits per fingerprint, for load factor and
+    // space reporting; Bloom filters have no slots and return 0
+    virtual size_t slots() const { return 0; }
+    virtual int fingerprint_bits() const { return 0; }
+
+    // query()/query_batch() never write, so any filter can be queried from many
+    // threads once loading is done. Filters returning true here also accept
+    // insert() and remove() from many threads, concurrently with queries.
+    virtual bool concurrent() const { return false; }
+
+    // False if the filter has no on-disk format
+    virtual bool image(FilterImage&) const { return false; }
+    shared_ptr<void> backing; // the mapped file of a filter from open_filter()
+
+    // Batched API. Overrides hash a group of BATCH keys, prefetch every line
+    // the group will touch, then resolve the group, so the misses overlap.
+    static constexpr size_t BATCH = 16;
+    virtual void query_batch(const uint64_t* keys, size_t n, uint8_t* out) {
+        for (size_t i = 0; i < n; i++) out[i] = query(keys[i]);
+    }
+    virtual void insert_batch(const uint64_t* keys, size_t n) {
+        for (size_t i = 0; i < n; i++) insert(keys[i]);
+    }
+
+    // Might any key in [lo, hi] be present? Point filters probe every key
+    // of a short range and cannot rule out a longer one; range filters
+    // (section 7) override this.
+    static constexpr uint64_t RANGE_PROBES = 64;
+    virtual bool query_range(uint64_t lo, uint64_t hi) {
+        if (lo > hi) return false;
+        if (hi - lo >= RANGE_PROBES) return true;
+        for (uint64_t k = lo; ; k++) {
+            if (query(k)) return true;
+            if (k == hi) return false;
+        }
+    }
+};
+
+// Runs resolve(i, j) for each key of each group of up to BATCH keys after
+// prepare(i, j) has been called on the whole group (i = key index, j = slot in group)
+template <typename Prepare, typename Resolve>
+inline void batch_pipeline(size_t n, Prepare prepare, Resolve resolve) {
+    for (size_t base = 0; base < n; base += Filter::BATCH) {
+        size_t g = min(Filter::BATCH, n - base);
+        for (size_t j = 0; j < g; j++) prepare(base + j, j);
+        for (size_t j = 0; j < g; j++) resolve(base + j, j);
+    }
+}
+
+// batch_pipeline with each group hashed up front by hash64x(seed);
+// prepare(i, j, h) and resolve(i, j, h) also get the key's hash
+template <typename Prepare, typename Resolve>
+inline void hashed_batch_pipeline(const uint64_t* keys, size_t n, uint64_t seed, Prepare prepare, Resolve resolve) {
+    uint64_t hs[Filter::BATCH];
+    for (size_t base = 0; base < n; base += Filter::BATCH) {
+        size_t g = min(Filter::BATCH, n - base);
+        hash64x(keys + base, g, seed, hs);
+        for (size_t j = 0; j < g; j++) prepare(base + j, j, hs[j]);
+        for (size_t j = 0; j < g; j++) resolve(base + j, j, hs[j]);
+    }
+}
+
+// Allocator for large tables of trivial types: calloc hands out lazily
+// zeroed pages, and construction without arguments writes nothing, so a
+// new table is paid for by page faults on first touch rather than by
+// one big memset (growing filters allocate while inserting)
+template <typename T>
+struct ZeroedAllocator {
+    using value_type = T;
+    ZeroedAllocator() = default;
+    template <typename U> ZeroedAllocator(const ZeroedAllocator<U>&) {}
+    T* allocate(size_t n) {
+        void* p = calloc(n, sizeof(T));
+        if (!p) throw bad_alloc();
+        return (T*)p;
+    }
+    void deallocate(T* p, size_t) { free(p); }
+    template <typename U> void construct(U* p) { ::new ((void*)p) U; }
+    template <typename U, typename... A> void construct(U* p, A&&... a) { ::new ((void*)p) U(forward<A>(a)...); }
+    template <typename U> bool operator==(const ZeroedAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const ZeroedAllocator<U>&) const { return false; }
 };
+template <typename T> using zvector = vector<T, ZeroedAllocator<T>>;
 
 // ================================================================
-// 1. Blocked Bloom Filter
+// 1. Standard Bloom Filter (baseline)
+// k probes, each a random bit of the whole array; the probes come from
+// two base hashes (Kirsch-Mitzenmacher) mapped with fastrange
 // ================================================================
 class BloomFilter : public Filter {
-    vector<uint64_t> bits;
+    vector<uint64_t> storage;
+    uint64_t* bits; // storage, or a mapped section
     size_t nbits, k, nblocks;
 public:
     BloomFilter(size_t n_entries, double target_fpr) {
         double m = -1.44 * n_entries * log2(target_fpr);
         nbits = (size_t)m;
-        bits.resize((nbits + 63) / 64);
+        storage.resize((nbits + 63) / 64);
+        bits = storage.data();
         k = max(1, int(round((nbits / (double)n_entries) * log(2))));
-        nblocks = bits.size();
+        nblocks = storage.size();
+    }
+
+    BloomFilter(const FilterImage& im) : nbits(im.params[0]), k(im.params[1]) {
+        bits = (uint64_t*)im.sections[0].data;
+        nblocks = (nbits + 63) / 64;
+    }
+
+    bool image(FilterImage& im) const override {
+        im.kind = KIND_BLOOM;
+        im.params[0] = nbits; im.params[1] = k;
+        im.add(bits, nblocks * 8);
+        return true;
     }
 
     void insert(uint64_t key) override {
+        DoubleHash d(key);
         for (size_t i = 0; i < k; i++) {
-            uint64_t h = hash64(key, i);
-            bits[(h % nbits) / 64] |= (1ULL << (h % 64));
+            uint64_t b = fastrange64(d.probe(i), nbits);
+            bits[b / 64] |= 1ULL << (b % 64);
         }
     }
 
-    bool query(uint64_t key) override {
+    bool query(uint64_t key) override { return test(DoubleHash(key)); }
+
+    bool test(const DoubleHash& d) const {
         for (size_t i = 0; i < k; i++) {
-            uint64_t h = hash64(key, i);
-            if (!(bits[(h % nbits) / 64] & (1ULL << (h % 64)))) return false;
+            uint64_t b = fastrange64(d.probe(i), nbits);
+            if (!(bits[b / 64] & (1ULL << (b % 64)))) return false;
         }
         return true;
     }
 
-    size_t size_bytes() const override { return bits.size() * 8; }
+    // the standard filter has k lines per key; prefetch all of them
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        uint64_t h2s[BATCH];
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t g = min(BATCH, n - base);
+            hash64x(keys + base, g, 1, h2s);
+            hashed_batch_pipeline(keys + base, g, 0,
+                [&](size_t, size_t j, uint64_t h) {
+                    DoubleHash d(h, h2s[j]);
+                    for (size_t p = 0; p < k; p++) __builtin_prefetch(&bits[fastrange64(d.probe(p), nbits) / 64]);
+                },
+                [&](size_t i, size_t j, uint64_t h) { out[base + i] = test(DoubleHash(h, h2s[j])); });
+        }
+    }
+
+    size_t size_bytes() const override { return nblocks * 8; }
 };
 
 // ================================================================
-// 2. XOR Filter (Static Build)
-// Simplified for demonstration; uses 3 hashes and prefilled keys.
+// 1b. Blocked Bloom Filters
+// One hash picks a block and every probe bit lives inside it, so a
+// query touches one cache line (or one word) instead of k random ones.
+//   Blocked512:    k bits anywhere in a 64-byte block
+//   Sectorized512: 64-byte block of eight 64-bit sectors, k/8 bits per sector
+//   Register64:    k bits in a single 64-bit word
+// Probe positions come from the low 32 hash bits times per-probe odd
+// salts; the block index uses fastrange on the full hash.
+// With ATOMIC, inserts set bits with a relaxed fetch_or per nonzero mask
+// word, so many threads can insert into one filter; queries stay plain
+// loads. A query racing with an insert of the same key may miss it,
+// which is fine: the insert has not finished yet.
 // ================================================================
-class XORFilter : public Filter {
-    vector<uint8_t> fp;
-    size_t size;
+static const uint32_t BLOOM_SALT[16] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+    0x9e3779b9U, 0x85ebca6bU, 0xc2b2ae35U, 0x27d4eb2fU, 0x165667b1U, 0xd3a2646dU, 0xfd7046c5U, 0xb55a4f09U,
+};
+
+// E[fpr_at(l)] for a block load l ~ Poisson(lambda)
+template <typename F>
+double poisson_expect(double lambda, F fpr_at) {
+    double sum = 0;
+    size_t hi = (size_t)(lambda + 12 * sqrt(lambda) + 30);
+    for (size_t l = 0; l <= hi; l++)
+        sum += exp(l * log(lambda) - lambda - lgamma(l + 1.0)) * fpr_at(l);
+    return sum;
+}
+
+// Fewest blocks whose expected FPR (blocks fill unevenly) meets the target
+template <typename F>
+size_t bloom_blocks_for(size_t n, double target, F fpr_at) {
+    size_t lo = 1, hi = max<size_t>(n, 1);
+    while (poisson_expect((double)n / hi, fpr_at) > target) hi *= 2;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (poisson_expect((double)n / mid, fpr_at) <= target) hi = mid; else lo = mid + 1;
+    }
+    return lo;
+}
+
+enum class BloomLayout { Blocked512, Sectorized512, Register64 };
+
+template <BloomLayout L, bool ATOMIC = false>
+class BlockedBloomFilter : public Filter {
+    static const int W = L == BloomLayout::Register64 ? 1 : 8; // words per block
+    vector<uint64_t> storage;
+    uint64_t* bits;   // storage rounded up to a 64-byte boundary
+    size_t nblocks;
+    int k;
+
+    // Expected FPR of one key with l keys already in its block
+    static double fpr_at(int k, size_t l) {
+        if (L == BloomLayout::Blocked512) return pow(1 - pow(1 - 1.0 / 512, (double)k * l), k);
+        if (L == BloomLayout::Sectorized512) return pow(1 - pow(1 - 1.0 / 64, (double)(k / 8) * l), k);
+        return pow(1 - pow(1 - 1.0 / 64, (double)k * l), k);
+    }
+
+    void make_mask(uint32_t h, uint64_t* m) const {
+#ifdef __AVX2__
+        if (L == BloomLayout::Sectorized512) {
+            __m256i hv = _mm256_set1_epi32(h), one = _mm256_set1_epi64x(1);
+            __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+            for (int j = 0; j < k; j += 8) { // one bit per sector per round
+                __m256i salt = _mm256_loadu_si256((const __m256i*)(BLOOM_SALT + j));
+                __m256i pos = _mm256_srli_epi32(_mm256_mullo_epi32(hv, salt), 26);
+                lo = _mm256_or_si256(lo, _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(pos))));
+                hi = _mm256_or_si256(hi, _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(pos, 1))));
+            }
+            _mm256_storeu_si256((__m256i*)m, lo);
+            _mm256_storeu_si256((__m256i*)(m + 4), hi);
+            return;
+        }
+#endif
+        for (int w = 0; w < W; w++) m[w] = 0;
+        for (int j = 0; j < k; j++) {
+            uint32_t p = h * BLOOM_SALT[j];
+            if (L == BloomLayout::Blocked512) m[p >> 29] |= 1ULL << ((p >> 23) & 63);
+            else if (L == BloomLayout::Sectorized512) m[j & 7] |= 1ULL << (p >> 26);
+            else m[0] |= 1ULL << (p >> 26);
+        }
+    }
+
 public:
-    XORFilter(size_t n_entries, int fp_bits = 8) {
-        size = n_entries * 1.23; // 23% overhead typical
-        fp.resize(size);
+    BlockedBloomFilter(size_t n_entries, double target_fpr) {
+        // pick k (and the block count it needs) for the fewest total bits
+        const int k_min = L == BloomLayout::Sectorized512 ? 8 : 1;
+        const int k_max = L == BloomLayout::Register64 ? 8 : 16;
+        const int k_step = L == BloomLayout::Sectorized512 ? 8 : 1;
+        nblocks = SIZE_MAX;
+        for (int kk = k_min; kk <= k_max; kk += k_step) {
+            size_t b = bloom_blocks_for(n_entries, target_fpr, [&](size_t l) { return fpr_at(kk, l); });
+            if (b < nblocks) { nblocks = b; k = kk; }
+        }
+        storage.assign(nblocks * W + 8, 0);
+        bits = (uint64_t*)(((uintptr_t)storage.data() + 63) & ~(uintptr_t)63);
+    }
+
+    BlockedBloomFilter(const FilterImage& im) : nblocks(im.params[2]), k((int)im.params[3]) {
+        bits = (uint64_t*)im.sections[0].data; // sections are page aligned
+    }
+
+    bool image(FilterImage& im) const override {
+        im.kind = KIND_BLOCKED_BLOOM;
+        im.params[0] = (uint64_t)L; im.params[1] = ATOMIC; im.params[2] = nblocks; im.params[3] = k;
+        im.add(bits, nblocks * W * 8);
+        return true;
+    }
+
+    void set_bits(uint64_t h) {
+        uint64_t* b = bits + fastrange64(h, nblocks) * W;
+        uint64_t m[W];
+        make_mask((uint32_t)h, m);
+        for (int w = 0; w < W; w++) {
+            if (!ATOMIC) b[w] |= m[w];
+            else if (m[w]) __atomic_fetch_or(&b[w], m[w], __ATOMIC_RELAXED);
+        }
     }
 
-    void build(const vector<uint64_t>& keys) {
-        for (auto k : keys) {
-            uint64_t h1 = hash64(k, 0) % size;
-            uint64_t h2 = hash64(k, 1) % size;
-            uint64_t h3 = hash64(k, 2) % size;
-            fp[h1] = fp[h2] ^ fp[h3] ^ (uint8_t)(hash64(k, 3) & 0xFF);
+    void insert(uint64_t key) override { set_bits(hash64(key)); }
+
+    bool query(uint64_t key) override { return test(hash64(key)); }
+
+    bool test(uint64_t h) const {
+        const uint64_t* b = bits + fastrange64(h, nblocks) * W;
+        uint64_t m[W];
+        make_mask((uint32_t)h, m);
+#ifdef __AVX2__
+        if (W == 8) { // all mask bits set in the block: testc on both 32-byte halves
+            __m256i b0 = _mm256_load_si256((const __m256i*)b), b1 = _mm256_load_si256((const __m256i*)(b + 4));
+            __m256i m0 = _mm256_loadu_si256((const __m256i*)m), m1 = _mm256_loadu_si256((const __m256i*)(m + 4));
+            return _mm256_testc_si256(b0, m0) & _mm256_testc_si256(b1, m1);
         }
+#endif
+        uint64_t miss = 0;
+        for (int w = 0; w < W; w++) miss |= m[w] & ~b[w];
+        return miss == 0;
     }
 
+    void insert_batch(const uint64_t* keys, size_t n) override {
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t, uint64_t h) { __builtin_prefetch(bits + fastrange64(h, nblocks) * W, 1); },
+            [&](size_t, size_t, uint64_t h) { set_bits(h); });
+    }
+
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t, uint64_t h) { __builtin_prefetch(bits + fastrange64(h, nblocks) * W); },
+            [&](size_t i, size_t, uint64_t h) { out[i] = test(h); });
+    }
+
+    size_t size_bytes() const override { return nblocks * W * 8; }
+    bool concurrent() const override { return ATOMIC; }
+};
+
+// ================================================================
+// 2. XOR Filters (Static Build)
+// 3-wise XOR filter and 3/4-wise binary fuse filters. Both are built
+// by peeling the key hypergraph: repeatedly take a slot that only one
+// key maps to, then assign fingerprints in reverse peeling order so
+// that the XOR of a key's slots equals its fingerprint.
+// ================================================================
+
+// Peels `hashes` (distinct key hashes) over array_len slots. locate(h, idx)
+// fills ARITY distinct slot indices. On success `order` holds (hash, slot)
+// pairs in peeling order; returns false if a 2-core remains (reseed and retry).
+template <int ARITY, typename Locate>
+bool xor_peel(const vector<uint64_t>& hashes, size_t array_len, Locate locate,
+              vector<pair<uint64_t, uint32_t>>& order) {
+    vector<uint8_t> count(array_len, 0);
+    vector<uint64_t> xorh(array_len, 0);
+    uint32_t idx[ARITY];
+    for (uint64_t h : hashes) {
+        locate(h, idx);
+        for (int j = 0; j < ARITY; j++) { count[idx[j]]++; xorh[idx[j]] ^= h; }
+    }
+
+    vector<uint32_t> queue;
+    for (size_t i = 0; i < array_len; i++) if (count[i] == 1) queue.push_back(i);
+    order.clear();
+    order.reserve(hashes.size());
+    while (!queue.empty()) {
+        uint32_t s = queue.back(); queue.pop_back();
+        if (count[s] != 1) continue; // peeled away since it was queued
+        uint64_t h = xorh[s];
+        order.push_back({h, s});
+        locate(h, idx);
+        for (int j = 0; j < ARITY; j++) {
+            count[idx[j]]--;
+            xorh[idx[j]] ^= h;
+            if (count[idx[j]] == 1) queue.push_back(idx[j]);
+        }
+    }
+    return order.size() == hashes.size();
+}
+
+// One counting-sort pass on the top 16 bits
+inline void partition_by_top_bits(vector<uint64_t>& v) {
+    vector<size_t> start(1 << 16 | 1, 0);
+    for (uint64_t h : v) start[(h >> 48) + 1]++;
+    for (size_t b = 1; b < start.size(); b++) start[b] += start[b - 1];
+    vector<uint64_t> out(v.size());
+    for (uint64_t h : v) out[start[h >> 48]++] = h;
+    v.swap(out);
+}
+
+template <typename FP>
+inline FP xor_fingerprint(uint64_t h) { return (FP)(h ^ (h >> 32)); }
+
+// Shared build/query for the XOR family; Derived provides locate() and
+// sizes fp before calling construct()
+template <typename FP, int ARITY, typename Derived>
+class XorFamilyFilter : public Filter {
+protected:
+    vector<FP> storage;
+    FP* fp = nullptr; // storage, or a mapped section
+    size_t fp_len = 0;
+    uint64_t seed = 0;
+    static const int MAX_ATTEMPTS = 100;
+
+    void allocate(size_t len) {
+        storage.assign(len, 0);
+        fp = storage.data();
+        fp_len = len;
+    }
+
+    void adopt(const FilterImage& im, uint64_t s) {
+        fp = (FP*)im.sections[0].data;
+        fp_len = im.sections[0].bytes / sizeof(FP);
+        seed = s;
+    }
+
+    void construct(const vector<uint64_t>& keys) {
+        vector<uint64_t> hashes(keys.size());
+        vector<pair<uint64_t, uint32_t>> order;
+        const Derived& self = static_cast<const Derived&>(*this);
+        auto locate = [&](uint64_t h, uint32_t* idx) { self.locate(h, idx); };
+        for (int attempt = 0; ; attempt++) {
+            if (attempt == MAX_ATTEMPTS) throw runtime_error("xor filter: peeling failed");
+            seed = hash64(attempt, 0x5eed);
+            hashes.resize(keys.size());
+            hash64x(keys.data(), keys.size(), seed, hashes.data());
+            if (attempt == 0) {
+                // locate() starts from fastrange of the hash, so ordering by the
+                // top bits walks the slot array front to back
+                partition_by_top_bits(hashes);
+            } else {
+                // equal hashes (duplicate keys) can never be peeled; drop them
+                sort(hashes.begin(), hashes.end());
+                hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+            }
+            if (xor_peel<ARITY>(hashes, fp_len, locate, order)) break;
+        }
+        fill(fp, fp + fp_len, 0);
+        uint32_t idx[ARITY];
+        for (size_t i = order.size(); i-- > 0; ) {
+            uint64_t h = order[i].first;
+            self.locate(h, idx);
+            FP v = xor_fingerprint<FP>(h);
+            for (int j = 0; j < ARITY; j++) v ^= fp[idx[j]]; // fp[own slot] is still 0
+            fp[order[i].second] = v;
+        }
+    }
+
+public:
+    void build(const vector<uint64_t>& keys) override { construct(keys); }
+
     bool query(uint64_t key) override {
-        uint64_t h1 = hash64(key, 0) % size;
-        uint64_t h2 = hash64(key, 1) % size;
-        uint64_t h3 = hash64(key, 2) % size;
-        uint8_t res = fp[h1] ^ fp[h2] ^ fp[h3];
-        return res == (uint8_t)(hash64(key, 3) & 0xFF);
+        uint64_t h = hash64(key, seed);
+        uint32_t idx[ARITY];
+        static_cast<const Derived&>(*this).locate(h, idx);
+        FP v = xor_fingerprint<FP>(h);
+        for (int j = 0; j < ARITY; j++) v ^= fp[idx[j]];
+        return v == 0;
+    }
+
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        const Derived& self = static_cast<const Derived&>(*this);
+        hashed_batch_pipeline(keys, n, seed,
+            [&](size_t, size_t, uint64_t h) {
+                uint32_t idx[ARITY];
+                self.locate(h, idx);
+                for (int a = 0; a < ARITY; a++) __builtin_prefetch(&fp[idx[a]]);
+            },
+            [&](size_t i, size_t, uint64_t h) { // locate() is cheap to redo; the lines are now cached
+                uint32_t idx[ARITY];
+                self.locate(h, idx);
+                FP v = xor_fingerprint<FP>(h);
+                for (int a = 0; a < ARITY; a++) v ^= fp[idx[a]];
+                out[i] = v == 0;
+            });
+    }
+
+    void insert(uint64_t) override {} // static: keys are supplied to build()
+    size_t size_bytes() const override { return fp_len * sizeof(FP); }
+    size_t slots() const override { return fp_len; }
+    int fingerprint_bits() const override { return 8 * sizeof(FP); }
+};
+
+// Classic XOR filter: 1.23n + 32 slots in three equal blocks, one hash per block
+template <typename FP>
+class XORFilter : public XorFamilyFilter<FP, 3, XORFilter<FP>> {
+    size_t block_len;
+public:
+    XORFilter(size_t n_entries) {
+        block_len = (32 + (size_t)(1.23 * n_entries)) / 3 + 1;
+        this->allocate(3 * block_len);
+    }
+
+    XORFilter(const FilterImage& im) : block_len(im.params[2]) { this->adopt(im, im.params[1]); }
+
+    bool image(FilterImage& im) const override {
+        im.kind = KIND_XOR;
+        im.params[0] = sizeof(FP); im.params[1] = this->seed; im.params[2] = block_len;
+        im.add(this->fp, this->fp_len * sizeof(FP));
+        return true;
+    }
+
+    void locate(uint64_t h, uint32_t* idx) const {
+        for (int j = 0; j < 3; j++) {
+            uint64_t r = (h << (21 * j)) | (h >> ((64 - 21 * j) & 63));
+            idx[j] = (uint32_t)(fastrange64(r, block_len) + j * block_len);
+        }
+    }
+};
+
+// Binary fuse filter: slots are split into small power-of-two segments and a
+// key's ARITY slots fall in ARITY consecutive segments, so construction and
+// queries stay local. Sizing follows Graf & Lemire (2022).
+template <typename FP, int ARITY>
+class BinaryFuseFilter : public XorFamilyFilter<FP, ARITY, BinaryFuseFilter<FP, ARITY>> {
+    uint32_t segment_len, segment_mask, segment_count_len;
+public:
+    BinaryFuseFilter(size_t n_entries) {
+        double n = max<size_t>(n_entries, 2);
+        segment_len = ARITY == 3 ? 1u << (int)floor(log(n) / log(3.33) + 2.25)
+                                 : 1u << (int)floor(log(n) / log(2.91) - 0.5);
+        segment_len = min<uint32_t>(max<uint32_t>(segment_len, 4), 1u << 18);
+        segment_mask = segment_len - 1;
+        double factor = ARITY == 3 ? max(1.125, 0.875 + 0.25 * log(1e6) / log(n))
+                                   : max(1.075, 0.77 + 0.305 * log(6e5) / log(n));
+        size_t capacity = (size_t)round(n * factor);
+        size_t segments = (capacity + segment_len - 1) / segment_len;
+        segments = segments <= ARITY - 1 ? 1 : segments - (ARITY - 1);
+        segment_count_len = segments * segment_len;
+        this->allocate((segments + ARITY - 1) * segment_len);
+    }
+
+    BinaryFuseFilter(const FilterImage& im)
+        : segment_len((uint32_t)im.params[3]), segment_mask(segment_len - 1),
+          segment_count_len((uint32_t)im.params[4]) {
+        this->adopt(im, im.params[2]);
+    }
+
+    bool image(FilterImage& im) const override {
+        im.kind = KIND_FUSE;
+        im.params[0] = sizeof(FP); im.params[1] = ARITY; im.params[2] = this->seed;
+        im.params[3] = segment_len; im.params[4] = segment_count_len;
+        im.add(this->fp, this->fp_len * sizeof(FP));
+        return true;
     }
 
-    void insert(uint64_t) override {}
-    size_t size_bytes() const override { return fp.size(); }
+    void locate(uint64_t h, uint32_t* idx) const {
+        static const int shift[4] = {0, 18, 0, 36}; // low bits of h not used by fastrange
+        uint32_t base = (uint32_t)fastrange64(h, segment_count_len);
+        idx[0] = base;
+        for (int j = 1; j < ARITY; j++) // next segment, offset scrambled within it
+            idx[j] = (base + j * segment_len) ^ ((uint32_t)(h >> shift[j]) & segment_mask);
+    }
 };
 
 // ================================================================
-// 3. Cuckoo Filter (Dynamic, safer version)
+// 3. Cuckoo Filter (Dynamic)
+// Partial-key cuckoo hashing over n buckets: a key's fingerprint lives
+// in bucket i1 or i2 = (hash(fp) - i1) mod n, so either bucket can be
+// recomputed from the other plus the fingerprint alone. The map is its
+// own inverse for any n, so the table is sized for its target load
+// instead of being rounded up to a power of two.
+//   FP_BITS   8, 12, 16 or 32; entries are bit-packed, no padding
+//   BUCKET    2, 4 or 8 entries per bucket
+//   SEMI_SORT (BUCKET 4, FP_BITS <= 12) sorts each bucket and codes
+//             the four high nibbles as one of 3876 multisets in 12
+//             bits, saving one bit per entry
+// A bucket is compared against the fingerprint in one branch-free
+// step (SWAR on 64-bit words, SSE/AVX2 for wide buckets). Victims
+// that cannot be placed after MAX_KICKS go to a small stash, so an
+// insert never drops a key; a full stash throws.
 // ================================================================
+struct SemiSortTables {
+    uint16_t dec[3876];    // code -> four sorted nibbles, nibble j at bits 4j
+    uint16_t enc[1 << 16]; // sorted nibbles -> code
+    SemiSortTables() {
+        int code = 0;
+        for (int a = 0; a < 16; a++) for (int b = a; b < 16; b++)
+            for (int c = b; c < 16; c++) for (int d = c; d < 16; d++) {
+                uint16_t packed = a | b << 4 | c << 8 | d << 12;
+                dec[code] = packed;
+                enc[packed] = code++;
+            }
+    }
+    static const SemiSortTables& get() { static SemiSortTables t; return t; }
+};
+
+inline uint64_t load_bits(const uint8_t* p, size_t bitpos) {
+    uint64_t w;
+    memcpy(&w, p + bitpos / 8, 8);
+    return w >> (bitpos % 8);
+}
+
+inline void store_bits(uint8_t* p, size_t bitpos, int width, uint64_t v) {
+    uint64_t w, m = ((1ULL << width) - 1) << (bitpos % 8);
+    memcpy(&w, p + bitpos / 8, 8);
+    w = (w & ~m) | ((v << (bitpos % 8)) & m);
+    memcpy(p + bitpos / 8, &w, 8);
+}
+
+template <int FP_BITS, int BUCKET, bool SEMI_SORT = false>
 class CuckooFilter : public Filter {
-    static const int BUCKET_SIZE = 4;
+protected:
+    static_assert(FP_BITS == 8 || FP_BITS == 12 || FP_BITS == 16 || FP_BITS == 32, "fingerprint bits");
+    static_assert(BUCKET == 2 || BUCKET == 4 || BUCKET == 8, "bucket size");
+    static_assert(!SEMI_SORT || (BUCKET == 4 && FP_BITS <= 12), "semi-sorting packs 4 entries of <= 12 bits");
+    static constexpr int BUCKET_BITS = SEMI_SORT ? BUCKET * FP_BITS - 4 : BUCKET * FP_BITS;
+    static constexpr int LANES = FP_BITS == 8 ? 8 : FP_BITS == 32 ? 2 : 4; // entries per SWAR word
     static const int MAX_KICKS = 500;
+    static const size_t STASH_MAX = 64;
 
-    struct Bucket {
-        uint8_t fp[BUCKET_SIZE];
-        Bucket() { memset(fp, 0, BUCKET_SIZE); }
-    };
-
-    vector<Bucket> table;
+    zvector<uint8_t> storage; // bit-packed buckets, plus slack for 8-byte loads
+    uint8_t* table;           // storage, or a mapped section
     size_t n_buckets;
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+    vector<pair<uint64_t, uint64_t>> stash; // (fingerprint, bucket), saved as is
+
+    uint64_t next_rand() { // xorshift64, no libc rand() on the insert path
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        return rng;
+    }
+
+    static uint32_t fingerprint_of(uint64_t h) {
+        uint32_t fp = (uint32_t)(h >> 32) & (uint32_t)((1ULL << FP_BITS) - 1);
+        return fp ? fp : 1; // 0 marks an empty entry
+    }
+
+    // (hash(fp) - i) mod n without a division; applying it twice gives i back
+    size_t alt_index(size_t i, uint32_t fp) const {
+        size_t d = fastrange64(hash64(fp, 2), n_buckets);
+        return d >= i ? d - i : d + n_buckets - i;
+    }
+
+    void read_bucket(size_t i, uint32_t* fps) const {
+        size_t base = i * BUCKET_BITS;
+        if (SEMI_SORT) {
+            uint64_t w = load_bits(table, base);
+            uint16_t nib = SemiSortTables::get().dec[w & 0xfff];
+            for (int j = 0; j < 4; j++)
+                fps[j] = (uint32_t)((nib >> (4 * j)) & 15) << (FP_BITS - 4) |
+                         ((uint32_t)(w >> (12 + j * (FP_BITS - 4))) & ((1u << (FP_BITS - 4)) - 1));
+        } else if (FP_BITS % 8 == 0) {
+            for (int j = 0; j < BUCKET; j++) {
+                fps[j] = 0;
+                memcpy(&fps[j], table + base / 8 + j * FP_BITS / 8, FP_BITS / 8);
+            }
+        } else {
+            for (int j = 0; j < BUCKET; j++)
+                fps[j] = (uint32_t)load_bits(table, base + j * FP_BITS) & (uint32_t)((1ULL << FP_BITS) - 1);
+        }
+    }
+
+    void write_bucket(size_t i, uint32_t* fps) {
+        size_t base = i * BUCKET_BITS;
+        if (SEMI_SORT) {
+            sort(fps, fps + 4);
+            uint64_t w = 0;
+            uint16_t nib = 0;
+            for (int j = 0; j < 4; j++) {
+                nib |= (fps[j] >> (FP_BITS - 4)) << (4 * j);
+                w |= (uint64_t)(fps[j] & ((1u << (FP_BITS - 4)) - 1)) << (12 + j * (FP_BITS - 4));
+            }
+            w |= SemiSortTables::get().enc[nib];
+            store_bits(table, base, BUCKET_BITS, w);
+        } else if (FP_BITS % 8 == 0) { // touches only this bucket's bytes
+            for (int j = 0; j < BUCKET; j++) memcpy(table + base / 8 + j * FP_BITS / 8, &fps[j], FP_BITS / 8);
+        } else {
+            for (int j = 0; j < BUCKET; j++) store_bits(table, base + j * FP_BITS, FP_BITS, fps[j]);
+        }
+    }
+
+    // True if any lane of FP_BITS in the low LANES*FP_BITS bits of w equals fp
+    static constexpr uint64_t lane_ones() { // 1 in the low bit of every lane
+        uint64_t o = 0;
+        for (int j = 0; (j + 1) * FP_BITS <= 64; j++) o |= 1ULL << (j * FP_BITS);
+        return o;
+    }
+
+    static bool swar_has(uint64_t w, uint32_t fp, int lanes) {
+        const uint64_t ones = lane_ones(), highs = ones << (FP_BITS - 1);
+        uint64_t lane_mask = lanes * FP_BITS == 64 ? ~0ULL : (1ULL << (lanes * FP_BITS)) - 1;
+        uint64_t x = (w ^ (fp * ones)) & lane_mask;
+        return ((x - ones) & ~x & highs & lane_mask) != 0;
+    }
+
+    bool bucket_has(size_t i, uint32_t fp) const {
+        size_t base = i * BUCKET_BITS;
+        if (SEMI_SORT) {
+            uint32_t fps[4];
+            read_bucket(i, fps);
+            uint64_t w = 0;
+            for (int j = 0; j < 4; j++) w |= (uint64_t)fps[j] << (j * FP_BITS);
+            return swar_has(w, fp, 4);
+        }
+#ifdef __AVX2__
+        const uint8_t* p = table + base / 8;
+        if (FP_BITS == 32 && BUCKET == 8)
+            return _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)p), _mm256_set1_epi32(fp)));
+        if (FP_BITS * BUCKET == 128 && FP_BITS >= 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)p);
+            __m128i t = FP_BITS == 16 ? _mm_set1_epi16((short)fp) : _mm_set1_epi32(fp);
+            return _mm_movemask_epi8(FP_BITS == 16 ? _mm_cmpeq_epi16(v, t) : _mm_cmpeq_epi32(v, t));
+        }
+#endif
+        bool hit = false;
+        for (int c = 0; c < BUCKET; c += LANES) // every chunk starts on a byte boundary
+            hit |= swar_has(load_bits(table, base + c * FP_BITS), fp, min(LANES, BUCKET - c));
+        return hit;
+    }
+
+    bool try_add(size_t i, uint32_t fp) {
+        uint32_t fps[BUCKET];
+        read_bucket(i, fps);
+        for (int j = 0; j < BUCKET; j++)
+            if (fps[j] == 0) { fps[j] = fp; write_bucket(i, fps); return true; }
+        return false;
+    }
+
+    bool try_remove(size_t i, uint32_t fp) {
+        uint32_t fps[BUCKET];
+        read_bucket(i, fps);
+        for (int j = 0; j < BUCKET; j++)
+            if (fps[j] == fp) { fps[j] = 0; write_bucket(i, fps); return true; }
+        return false;
+    }
+
+    const uint8_t* bucket_addr(size_t i) const { return table + i * BUCKET_BITS / 8; }
 
 public:
+    // highest load each bucket size reliably reaches
+    static constexpr double MAX_LOAD = BUCKET == 2 ? 0.84 : BUCKET == 4 ? 0.95 : 0.98;
+
+    // n_entries fill the table to MAX_LOAD
     CuckooFilter(size_t n_entries) {
-        // allocate more space to avoid overfill crashes
-        n_buckets = (size_t)(n_entries / BUCKET_SIZE * 2.0);
-        table.resize(n_buckets);
+        n_buckets = max<size_t>(2, (size_t)ceil(max(n_entries, (size_t)1) / (BUCKET * MAX_LOAD)));
+        storage.resize(table_bytes());
+        table = storage.data();
     }
 
-    inline uint8_t fingerprint(uint64_t key) const {
+    // Stash entries are copied out of the image; the table is used in place
+    CuckooFilter(const FilterImage& im) : n_buckets(im.params[3]) {
+        table = (uint8_t*)im.sections[0].data;
+        auto st = (const pair<uint64_t, uint64_t>*)im.sections[1].data;
+        stash.assign(st, st + im.sections[1].bytes / sizeof(*st));
+    }
+
+    bool image(FilterImage& im) const override {
+        im.kind = KIND_CUCKOO;
+        im.params[0] = FP_BITS; im.params[1] = BUCKET; im.params[2] = SEMI_SORT; im.params[3] = n_buckets;
+        im.add(table, table_bytes());
+        im.add(stash.data(), stash.size() * sizeof(stash[0]));
+        return true;
+    }
+
+    size_t table_bytes() const { return (n_buckets * BUCKET_BITS + 7) / 8 + 32; }
+
+    // fastrange of the low hash half (the fingerprint is the high half); n < 2^32
+    size_t index1(uint64_t h) const { return (size_t)(((h & 0xffffffffULL) * n_buckets) >> 32); }
+
+    void insert(uint64_t key) override {
         uint64_t h = hash64(key, 0);
-        return (uint8_t)((h & 0xFF) + 1); // never zero
+        uint32_t fp = fingerprint_of(h);
+        size_t i1 = index1(h);
+        insert_at(fp, i1, alt_index(i1, fp));
     }
 
-    inline size_t index1(uint64_t key) const {
-        return hash64(key, 1) % n_buckets;
+    void insert_at(uint32_t fp, size_t i1, size_t i2) {
+        if (try_add(i1, fp) || try_add(i2, fp)) return;
+
+        size_t i = (next_rand() & 1) ? i1 : i2;
+        for (int kick = 0; kick < MAX_KICKS; kick++) {
+            uint32_t fps[BUCKET];
+            read_bucket(i, fps);
+            int j = next_rand() % BUCKET;
+            swap(fp, fps[j]);
+            write_bucket(i, fps);
+            i = alt_index(i, fp);
+            if (try_add(i, fp)) return;
+        }
+        // the table is too full to place the last victim; keep it
+        if (stash.size() >= STASH_MAX) throw runtime_error("cuckoo filter: stash full");
+        stash.push_back({fp, i});
     }
 
-    inline size_t index2(size_t i1, uint8_t fp) const {
-        // XOR the fingerprint with a hash of itself, then mod table size
-        return (i1 ^ (hash64(fp, 2) % n_buckets)) % n_buckets;
+    bool query(uint64_t key) override {
+        uint64_t h = hash64(key, 0);
+        uint32_t fp = fingerprint_of(h);
+        size_t i1 = index1(h);
+        return lookup(fp, i1, alt_index(i1, fp));
     }
 
-    void insert(uint64_t key) override {
-        uint8_t fp = fingerprint(key);
-        size_t i1 = index1(key);
-        size_t i2 = index2(i1, fp);
-
-        // try both buckets directly
-        for (auto i : {i1, i2}) {
-            for (int j = 0; j < BUCKET_SIZE; j++) {
-                if (table[i].fp[j] == 0) {
-                    table[i].fp[j] = fp;
-                    return;
-                }
+    bool lookup(uint32_t fp, size_t i1, size_t i2) const {
+        bool hit = bucket_has(i1, fp) | bucket_has(i2, fp);
+        if (stash.empty()) return hit;
+        for (auto& s : stash)
+            hit |= s.first == fp && (s.second == i1 || s.second == i2);
+        return hit;
+    }
+
+    // Both candidate buckets of every key in the group are prefetched first
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        uint32_t fps[BATCH]; size_t i1s[BATCH], i2s[BATCH];
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t j, uint64_t h) {
+                fps[j] = fingerprint_of(h);
+                i1s[j] = index1(h);
+                i2s[j] = alt_index(i1s[j], fps[j]);
+                __builtin_prefetch(bucket_addr(i1s[j]));
+                __builtin_prefetch(bucket_addr(i2s[j]));
+            },
+            [&](size_t i, size_t j, uint64_t) { out[i] = lookup(fps[j], i1s[j], i2s[j]); });
+    }
+
+    void insert_batch(const uint64_t* keys, size_t n) override {
+        uint32_t fps[BATCH]; size_t i1s[BATCH], i2s[BATCH];
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t j, uint64_t h) {
+                fps[j] = fingerprint_of(h);
+                i1s[j] = index1(h);
+                i2s[j] = alt_index(i1s[j], fps[j]);
+                __builtin_prefetch(bucket_addr(i1s[j]), 1);
+                __builtin_prefetch(bucket_addr(i2s[j]), 1);
+            },
+            [&](size_t, size_t j, uint64_t) { insert_at(fps[j], i1s[j], i2s[j]); });
+    }
+
+    void remove(uint64_t key) override {
+        uint64_t h = hash64(key, 0);
+        uint32_t fp = fingerprint_of(h);
+        size_t i1 = index1(h), i2 = alt_index(i1, fp);
+        if (try_remove(i1, fp) || try_remove(i2, fp)) return;
+        for (size_t s = 0; s < stash.size(); s++)
+            if (stash[s].first == fp && (stash[s].second == i1 || stash[s].second == i2)) {
+                stash.erase(stash.begin() + s);
+                return;
             }
+    }
+
+    size_t size_bytes() const override { return (n_buckets * BUCKET_BITS + 7) / 8; }
+    size_t slots() const override { return n_buckets * BUCKET; }
+    int fingerprint_bits() const override { return FP_BITS; }
+};
+
+// ================================================================
+// 3b. Concurrent Cuckoo Filter
+// Same table as CuckooFilter (byte-aligned fingerprints only, so a
+// bucket write never touches a neighbour's bytes), guarded by 1024
+// striped seqlocks: a stripe's version is odd while a writer holds it.
+//   query   reads both buckets without locking and retries if either
+//           stripe was locked or changed meanwhile (optimistic)
+//   insert  locks the two stripes (in order) and tries both buckets;
+//           if full, it walks a cuckoo path without moving anything,
+//           then applies the moves from the free end backwards. Each
+//           move copies one fingerprint into an empty slot of its
+//           other bucket under both stripes, so a stored key is always
+//           in one of its buckets. A move whose source changed aborts
+//           the path and the insert starts over.
+// ================================================================
+template <int FP_BITS, int BUCKET>
+class ConcurrentCuckooFilter : public CuckooFilter<FP_BITS, BUCKET> {
+    using Base = CuckooFilter<FP_BITS, BUCKET>;
+    using Base::MAX_KICKS; using Base::STASH_MAX; using Base::stash;
+    using Base::fingerprint_of; using Base::index1; using Base::alt_index;
+    using Base::read_bucket; using Base::write_bucket; using Base::bucket_has;
+    using Base::try_add; using Base::try_remove; using Base::bucket_addr;
+    static_assert(FP_BITS % 8 == 0, "concurrent cuckoo needs byte-aligned fingerprints");
+    static const size_t N_STRIPES = 1024;
+    static const int MAX_RETRIES = 16;
+
+    struct alignas(64) Stripe { atomic<uint32_t> version{0}; };
+    vector<Stripe> stripes = vector<Stripe>(N_STRIPES);
+    mutex stash_mu;
+    atomic<size_t> stash_n{0};
+
+    atomic<uint32_t>& stripe(size_t i) { return stripes[i & (N_STRIPES - 1)].version; }
+
+    // pause, and give up the core now and then in case the holder was preempted
+    static void backoff(int spin) {
+        if (spin % 64 == 63) this_thread::yield(); else _mm_pause();
+    }
+
+    static void lock(atomic<uint32_t>& v) {
+        for (int spin = 0;; spin++) {
+            uint32_t cur = v.load(memory_order_relaxed);
+            if (!(cur & 1) && v.compare_exchange_weak(cur, cur + 1, memory_order_acquire)) return;
+            backoff(spin);
         }
+    }
 
-        // perform eviction if both full
-        size_t i = (rand() & 1) ? i1 : i2;
-        for (int kick = 0; kick < MAX_KICKS; kick++) {
-            int j = rand() % BUCKET_SIZE;
-            uint8_t old = table[i].fp[j];
-            table[i].fp[j] = fp;
-            fp = old;
-            i = index2(i, fp);
-            if (i >= n_buckets) i %= n_buckets; // safety wrap
-            for (int k = 0; k < BUCKET_SIZE; k++) {
-                if (table[i].fp[k] == 0) {
-                    table[i].fp[k] = fp;
-                    return;
-                }
+    // Locks the stripes of buckets a and b in address order; returns how many were taken
+    int lock_pair(size_t a, size_t b) {
+        atomic<uint32_t> *x = &stripe(a), *y = &stripe(b);
+        if (x > y) swap(x, y);
+        lock(*x);
+        if (x == y) return 1;
+        lock(*y);
+        return 2;
+    }
+
+    void unlock_pair(size_t a, size_t b) {
+        atomic<uint32_t> *x = &stripe(a), *y = &stripe(b);
+        x->fetch_add(1, memory_order_release);
+        if (x != y) y->fetch_add(1, memory_order_release);
+    }
+
+    static uint64_t next_rand() { // per-thread xorshift64
+        static thread_local uint64_t r = 0x9e3779b97f4a7c15ULL ^ (uintptr_t)&r;
+        r ^= r << 13; r ^= r >> 7; r ^= r << 17;
+        return r;
+    }
+
+    // Moves one fingerprint of bucket i to its other bucket, so a later
+    // try_add on i can succeed. False if no path was found or one went stale.
+    bool make_room(size_t i) {
+        struct Step { size_t bucket; int slot; uint32_t fp; };
+        static thread_local vector<Step> path;
+        path.clear();
+        uint32_t fps[BUCKET];
+        for (int depth = 0; depth < MAX_KICKS; depth++) {
+            read_bucket(i, fps); // unlocked snapshot; every step is re-checked under the locks
+            int slot = next_rand() % BUCKET;
+            if (fps[slot] == 0) break;
+            path.push_back({i, slot, fps[slot]});
+            i = alt_index(i, fps[slot]);
+            read_bucket(i, fps);
+            bool has_empty = false;
+            for (int j = 0; j < BUCKET; j++) has_empty |= fps[j] == 0;
+            if (has_empty) break;
+        }
+        if (path.empty()) return true;
+        for (size_t k = path.size(); k-- > 0;) {
+            const Step& s = path[k];
+            size_t dst = alt_index(s.bucket, s.fp);
+            lock_pair(s.bucket, dst);
+            uint32_t src_fps[BUCKET], dst_fps[BUCKET];
+            read_bucket(s.bucket, src_fps);
+            read_bucket(dst, dst_fps);
+            int free_slot = -1;
+            for (int j = 0; j < BUCKET && free_slot < 0; j++) if (dst_fps[j] == 0) free_slot = j;
+            bool ok = src_fps[s.slot] == s.fp && free_slot >= 0 && dst != s.bucket;
+            if (ok) {
+                dst_fps[free_slot] = s.fp;
+                write_bucket(dst, dst_fps);
+                src_fps[s.slot] = 0;
+                write_bucket(s.bucket, src_fps);
             }
+            unlock_pair(s.bucket, dst);
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    bool add_locked(uint32_t fp, size_t i1, size_t i2) {
+        lock_pair(i1, i2);
+        bool ok = try_add(i1, fp) || try_add(i2, fp);
+        unlock_pair(i1, i2);
+        return ok;
+    }
+
+    bool lookup(uint32_t fp, size_t i1, size_t i2) {
+        atomic<uint32_t> &s1 = stripe(i1), &s2 = stripe(i2);
+        for (int spin = 0;; spin++) {
+            uint32_t v1 = s1.load(memory_order_acquire), v2 = s2.load(memory_order_acquire);
+            if ((v1 | v2) & 1) { backoff(spin); continue; }
+            bool hit = bucket_has(i1, fp) | bucket_has(i2, fp);
+            atomic_thread_fence(memory_order_acquire);
+            if (s1.load(memory_order_relaxed) != v1 || s2.load(memory_order_relaxed) != v2) continue;
+            if (hit || stash_n.load(memory_order_acquire) == 0) return hit;
+            lock_guard<mutex> g(stash_mu);
+            for (auto& s : stash)
+                if (s.first == fp && (s.second == i1 || s.second == i2)) return true;
+            return false;
         }
+    }
 
-        // if we reach here, insertion failed (table too full)
-        // (In production, you’d grow or stash.)
+public:
+    ConcurrentCuckooFilter(size_t n_entries) : Base(n_entries) {}
+
+    void insert(uint64_t key) override {
+        uint64_t h = hash64(key, 0);
+        uint32_t fp = fingerprint_of(h);
+        size_t i1 = index1(h), i2 = alt_index(i1, fp);
+        for (int attempt = 0; attempt < MAX_RETRIES; attempt++) {
+            if (add_locked(fp, i1, i2)) return;
+            make_room(next_rand() & 1 ? i1 : i2);
+        }
+        lock_guard<mutex> g(stash_mu);
+        if (stash.size() >= STASH_MAX) throw runtime_error("cuckoo filter: stash full");
+        stash.push_back({fp, i1});
+        stash_n.store(stash.size(), memory_order_release);
     }
 
     bool query(uint64_t key) override {
-        uint8_t fp = fingerprint(key);
-        size_t i1 = index1(key);
-        size_t i2 = index2(i1, fp);
-        for (auto i : {i1, i2})
-            for (int j = 0; j < BUCKET_SIZE; j++)
-                if (table[i].fp[j] == fp) return true;
-        return false;
+        uint64_t h = hash64(key, 0);
+        uint32_t fp = fingerprint_of(h);
+        size_t i1 = index1(h);
+        return lookup(fp, i1, alt_index(i1, fp));
     }
 
-    void remove(uint64_t key) override {
-        uint8_t fp = fingerprint(key);
-        size_t i1 = index1(key);
-        size_t i2 = index2(i1, fp);
-        for (auto i : {i1, i2})
-            for (int j = 0; j < BUCKET_SIZE; j++)
-                if (table[i].fp[j] == fp) {
-                    table[i].fp[j] = 0;
-                    return;
-                }
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        uint32_t fps[Filter::BATCH]; size_t i1s[Filter::BATCH], i2s[Filter::BATCH];
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t j, uint64_t h) {
+                fps[j] = fingerprint_of(h);
+                i1s[j] = index1(h);
+                i2s[j] = alt_index(i1s[j], fps[j]);
+                __builtin_prefetch(bucket_addr(i1s[j]));
+                __builtin_prefetch(bucket_addr(i2s[j]));
+            },
+            [&](size_t i, size_t j, uint64_t) { out[i] = lookup(fps[j], i1s[j], i2s[j]); });
     }
 
-    size_t size_bytes() const override {
-        return n_buckets * sizeof(Bucket);
+    void insert_batch(const uint64_t* keys, size_t n) override {
+        for (size_t i = 0; i < n; i++) insert(keys[i]);
     }
+
+    void remove(uint64_t key) override {
+        uint64_t h = hash64(key, 0);
+        uint32_t fp = fingerprint_of(h);
+        size_t i1 = index1(h), i2 = alt_index(i1, fp);
+        lock_pair(i1, i2);
+        bool ok = try_remove(i1, fp) || try_remove(i2, fp);
+        unlock_pair(i1, i2);
+        if (ok || stash_n.load(memory_order_acquire) == 0) return;
+        lock_guard<mutex> g(stash_mu);
+        for (size_t s = 0; s < stash.size(); s++)
+            if (stash[s].first == fp && (stash[s].second == i1 || stash[s].second == i2)) {
+                stash.erase(stash.begin() + s);
+                stash_n.store(stash.size(), memory_order_release);
+                return;
+            }
+    }
+
+    bool concurrent() const override { return true; }
 };
 
+// Runtime fingerprint width -> CuckooFilter instantiation
+template <int BUCKET, bool SEMI_SORT = false>
+Filter* make_cuckoo(int fp_bits, size_t n_entries) {
+    if (fp_bits <= 8)  return new CuckooFilter<8, BUCKET, SEMI_SORT>(n_entries);
+    if (fp_bits <= 12) return new CuckooFilter<12, BUCKET, SEMI_SORT>(n_entries);
+    if (SEMI_SORT)     return new CuckooFilter<12, BUCKET, SEMI_SORT>(n_entries);
+    if (fp_bits <= 16) return new CuckooFilter<16, BUCKET, false>(n_entries);
+    return new CuckooFilter<32, BUCKET, false>(n_entries);
+}
+
+// Concurrent variant; 12-bit fingerprints are rounded up to 16 bits
+template <int BUCKET>
+Filter* make_concurrent_cuckoo(int fp_bits, size_t n_entries) {
+    if (fp_bits <= 8)  return new ConcurrentCuckooFilter<8, BUCKET>(n_entries);
+    if (fp_bits <= 16) return new ConcurrentCuckooFilter<16, BUCKET>(n_entries);
+    return new ConcurrentCuckooFilter<32, BUCKET>(n_entries);
+}
 
 // ================================================================
-// 4. Quotient Filter (Optimized Dynamic)
+// 4. Quotient Filter (rank-select layout, RSQF-style)
+// A key's fingerprint is split into a quotient (home slot) and a
+// remainder. Remainders of one quotient form a sorted run; runs are
+// stored in quotient order and shift right into later slots as
+// clusters grow. Metadata is kept per 64-slot block:
+//   occupieds  bit i: quotient i has a run
+//   runends    bit i: slot i is the last slot of a run
+//   offset     slots at the block start taken by runs of earlier
+//              quotients (255 = saturated, recomputed on demand);
+//              one byte per block, kept in a separate small array
+// i.e. 2.125 metadata bits per slot. A quotient's run end is found
+// with one rank over occupieds and one select over runends.
+// Duplicate keys are kept as repeated remainders, which gives
+// counting; remove() deletes one copy.
+// The fingerprint is the top qbits + rbits hash bits, so a table with
+// one more quotient bit and one less remainder bit (rbits <= 8*sizeof(R))
+// sees the same fingerprints; GrowingQuotientFilter doubles that way.
 // ================================================================
-#include <immintrin.h> // AVX2 intrinsics
+inline int select64(uint64_t x, int k) { // position of the k-th (0-based) set bit
+#ifdef __BMI2__
+    return __builtin_ctzll(_pdep_u64(1ULL << k, x));
+#else
+    for (int i = 0; i < k; i++) x &= x - 1;
+    return __builtin_ctzll(x);
+#endif
+}
 
+template <typename R>
 class QuotientFilter : public Filter {
-    struct alignas(64) Slot { // align to cache line
-        uint16_t remainder;
-        uint8_t meta; // bit0=occupied, bit1=shifted
+    struct Block {
+        uint64_t occupieds;
+        uint64_t runends;
+        R rem[64];
     };
+    static const int RBITS = 8 * sizeof(R);
+
+    zvector<Block> block_store;
+    zvector<uint8_t> offset_store;
+    Block* blocks;    // block_store, or a mapped section
+    uint8_t* offsets; // offset_store, or a mapped section
+    size_t n_blocks, qbits, nslots, total_slots, n_items = 0;
+    int rbits;
+
+    bool occupied(size_t q) const { return blocks[q >> 6].occupieds >> (q & 63) & 1; }
+    bool runend(size_t s) const { return blocks[s >> 6].runends >> (s & 63) & 1; }
+    void set_runend(size_t s, bool v) {
+        uint64_t bit = 1ULL << (s & 63);
+        if (v) blocks[s >> 6].runends |= bit; else blocks[s >> 6].runends &= ~bit;
+    }
+    R& rem(size_t s) { return blocks[s >> 6].rem[s & 63]; }
+
+    size_t offset(size_t b) const {
+        return offsets[b] < 255 ? offsets[b] : block_offset(b);
+    }
+    size_t block_offset(size_t b) const {
+        if (b == 0) return 0;
+        long e = last_runend(64 * b - 1);
+        return max<long>(0, e - (long)(64 * b) + 1);
+    }
+
+    // Slot of the last run end among quotients <= s; below s if no run covers s
+    long last_runend(size_t s) const {
+        size_t b = s >> 6, off = offset(b);
+        int d = __builtin_popcountll(blocks[b].occupieds & ((2ULL << (s & 63)) - 1));
+        if (d == 0) return (long)(64 * b + off) - 1;
+        size_t rb = b + off / 64; // the first `off` slots end runs of earlier blocks
+        uint64_t ends = blocks[rb].runends & ~((1ULL << (off % 64)) - 1);
+        while (__builtin_popcountll(ends) < d) {
+            d -= __builtin_popcountll(ends);
+            ends = blocks[++rb].runends;
+        }
+        return (long)(64 * rb + select64(ends, d - 1));
+    }
+
+    size_t run_start(size_t q) const {
+        return q == 0 ? 0 : (size_t)max<long>((long)q, last_runend(q - 1) + 1);
+    }
+
+    size_t find_first_empty(size_t s) const {
+        while (s < total_slots) {
+            long e = last_runend(s);
+            if (e < (long)s) return s;
+            s = e + 1;
+        }
+        return total_slots;
+    }
+
+    // Blocks starting in (lo, hi] may have had runs shifted across their start
+    void update_offsets(size_t lo, size_t hi) {
+        for (size_t b = lo / 64 + 1; b < n_blocks && 64 * b <= hi; b++)
+            offsets[b] = (uint8_t)min<size_t>(block_offset(b), 255);
+    }
+
+    // Bitmask of slots in block b whose remainder equals r
+    uint64_t match_mask(size_t b, R r) const {
+        const R* p = blocks[b].rem;
+#ifdef __AVX2__
+        if (RBITS == 8) {
+            __m256i t = _mm256_set1_epi8((char)r);
+            uint32_t lo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), t));
+            uint32_t hi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), t));
+            return (uint64_t)hi << 32 | lo;
+        } else {
+            __m256i t = _mm256_set1_epi16((short)r);
+            uint64_t m = 0;
+            for (int i = 0; i < 2; i++) { // 32 slots per round: pack two 16-lane compares to bytes
+                __m256i a = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i*)(p + 32 * i)), t);
+                __m256i c = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i*)(p + 32 * i + 16)), t);
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, c), 0xd8);
+                m |= (uint64_t)(uint32_t)_mm256_movemask_epi8(packed) << (32 * i);
+            }
+            return m;
+        }
+#else
+        uint64_t m = 0;
+        for (int i = 0; i < 64; i++) m |= (uint64_t)(p[i] == r) << i;
+        return m;
+#endif
+    }
 
-    vector<Slot> table;
-    size_t qbits, rbits, size;
-    const uint8_t OCCUPIED = 1;
-    const uint8_t SHIFTED  = 2;
-    const size_t MAX_SHIFT = 32;  // limit cluster shifts
-    const size_t SIMD_WIDTH = 16; // AVX2: 16x16-bit integers
+    // Occurrences of r in slots [start, end], one block at a time
+    size_t count_in(size_t start, size_t end, R r, bool first_only) const {
+        size_t n = 0;
+        for (size_t s = start; s <= end; s = (s | 63) + 1) {
+            size_t b = s >> 6, last = min(end, s | 63);
+            uint64_t range = (~0ULL << (s & 63)) & (~0ULL >> (63 - (last & 63)));
+            n += __builtin_popcountll(match_mask(b, r) & range);
+            if (first_only && n) return n;
+        }
+        return n;
+    }
 
 public:
-    QuotientFilter(size_t n_entries, int rbits_ = 8) {
-        qbits = ceil(log2(n_entries));
-        rbits = rbits_;
-        size = (1ULL << qbits) * 2; // low load factor for faster inserts
-        table.resize(size);
-        memset(table.data(), 0, table.size() * sizeof(Slot));
+    static constexpr double MAX_LOAD = 0.95;
+
+    void split(uint64_t h, size_t& q, R& r) const {
+        uint64_t f = h >> (64 - qbits - rbits);
+        q = f >> rbits;
+        r = (R)(f & ((1ULL << rbits) - 1));
     }
 
-    void insert(uint64_t key) override {
-        uint64_t h = hash64(key, 0);
-        size_t q = (h >> rbits) % size;
-        uint16_t r = h & ((1ULL << rbits) - 1);
+    QuotientFilter(size_t n_entries, int remainder_bits = RBITS) : rbits(remainder_bits) {
+        // at most MAX_LOAD of the power-of-two quotient space in use
+        qbits = max<size_t>(6, (size_t)ceil(log2(max(n_entries, (size_t)1) / MAX_LOAD)));
+        nslots = 1ULL << qbits;
+        // runs past the last quotient spill into extra blocks instead of wrapping
+        size_t extra = max<size_t>(2, (size_t)(10 * sqrt((double)nslots)) / 64 + 1);
+        n_blocks = nslots / 64 + extra;
+        block_store.resize(n_blocks);
+        offset_store.resize(n_blocks);
+        blocks = block_store.data();
+        offsets = offset_store.data();
+        total_slots = n_blocks * 64;
+    }
+
+    QuotientFilter(const FilterImage& im)
+        : n_blocks(im.params[4]), qbits(im.params[1]), n_items(im.params[3]), rbits((int)im.params[2]) {
+        nslots = 1ULL << qbits;
+        total_slots = n_blocks * 64;
+        blocks = (Block*)im.sections[0].data;
+        offsets = (uint8_t*)im.sections[1].data;
+    }
+
+    bool image(FilterImage& im) const override {
+        im.kind = KIND_QUOTIENT;
+        im.params[0] = sizeof(R); im.params[1] = qbits; im.params[2] = rbits;
+        im.params[3] = n_items; im.params[4] = n_blocks;
+        im.add(blocks, n_blocks * sizeof(Block));
+        im.add(offsets, n_blocks);
+        return true;
+    }
+
+    void insert(uint64_t key) override { insert_hash(hash64(key, 0)); }
+
+    void insert_hash(uint64_t h) {
+        size_t q; R r;
+        split(h, q, r);
+        insert_fp(q, r);
+    }
 
-        size_t pos = q;
-        size_t shift_count = 0;
-        while (table[pos].meta & OCCUPIED) {
-            pos = (pos + 1) % size;
-            shift_count++;
-            if (shift_count > MAX_SHIFT) return; // bounded shift
+    void insert_fp(size_t q, R r) {
+        long e = last_runend(q);
+        bool new_run = !occupied(q);
+        size_t pos;
+        if (new_run) pos = max<long>((long)q, e + 1);
+        else {
+            pos = run_start(q);
+            while ((long)pos <= e && rem(pos) <= r) pos++; // keep the run sorted
         }
+        size_t empty = find_first_empty(pos);
+        if (empty >= total_slots) throw runtime_error("quotient filter: out of slots");
 
-        table[pos].remainder = r;
-        table[pos].meta = OCCUPIED | ((pos != q) ? SHIFTED : 0);
+        for (size_t i = empty; i > pos; i--) {
+            rem(i) = rem(i - 1);
+            set_runend(i, runend(i - 1));
+        }
+        rem(pos) = r;
+        if (new_run) {
+            blocks[q >> 6].occupieds |= 1ULL << (q & 63);
+            set_runend(pos, true);
+        } else if ((long)pos == e + 1) { // appended: the run now ends one slot later
+            set_runend(pos - 1, false);
+            set_runend(pos, true);
+        } else {
+            set_runend(pos, false);
+        }
+        update_offsets(q, empty);
+        n_items++;
     }
 
-    bool query(uint64_t key) override {
-        uint64_t h = hash64(key, 0);
-        size_t q = (h >> rbits) % size;
-        uint16_t r = h & ((1ULL << rbits) - 1);
+    bool query(uint64_t key) override { return query_hash(hash64(key, 0)); }
+
+    // Home block of every key in the group is prefetched first
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t, uint64_t h) {
+                size_t q; R r;
+                split(h, q, r);
+                __builtin_prefetch(&blocks[q >> 6]);
+            },
+            [&](size_t i, size_t, uint64_t h) { out[i] = query_hash(h); });
+    }
+
+    void insert_batch(const uint64_t* keys, size_t n) override {
+        hashed_batch_pipeline(keys, n, 0,
+            [&](size_t, size_t, uint64_t h) {
+                size_t q; R r;
+                split(h, q, r);
+                __builtin_prefetch(&blocks[q >> 6], 1);
+            },
+            [&](size_t, size_t, uint64_t h) { insert_hash(h); });
+    }
 
-        size_t pos = q;
-        size_t scanned = 0;
-        __m256i target_fp = _mm256_set1_epi16(r);
+    bool query_hash(uint64_t h) const {
+        size_t q; R r;
+        split(h, q, r);
+        if (!occupied(q)) return false;
+        return count_in(run_start(q), last_runend(q), r, true) > 0;
+    }
+
+    // Copies of the key's fingerprint (inserts minus removes, plus collisions)
+    size_t count(uint64_t key) const {
+        size_t q; R r;
+        split(hash64(key, 0), q, r);
+        if (!occupied(q)) return 0;
+        return count_in(run_start(q), last_runend(q), r, false);
+    }
 
-        while ((table[pos].meta & OCCUPIED) && scanned < MAX_SHIFT) {
-            size_t remaining = min(SIMD_WIDTH, size - pos);
-            __m256i data = _mm256_loadu_si256((__m256i*)&table[pos]);
-            __m256i cmp = _mm256_cmpeq_epi16(data, target_fp);
-            int mask = _mm256_movemask_epi8(cmp);
-            if (mask) return true;
+    void remove(uint64_t key) override {
+        size_t q; R r;
+        split(hash64(key, 0), q, r);
+        if (!occupied(q)) return;
+        size_t start = run_start(q), e = last_runend(q), p = start;
+        while (p <= e && rem(p) != r) p++;
+        if (p > e) return;
+
+        // close the gap inside the run
+        for (size_t i = p; i < e; i++) rem(i) = rem(i + 1);
+        set_runend(e, false);
+        if (start == e) blocks[q >> 6].occupieds &= ~(1ULL << (q & 63));
+        else set_runend(e - 1, true);
 
-            pos = (pos + SIMD_WIDTH) % size;
-            scanned += SIMD_WIDTH;
+        // later runs of the cluster that sit right of their home slot move left
+        size_t hole = e, qn = q + 1;
+        for (;;) {
+            while (qn <= hole && !occupied(qn)) qn++;
+            if (qn > hole) break;
+            size_t en = hole + 1;
+            while (!runend(en)) en++;
+            for (size_t i = hole; i < en; i++) rem(i) = rem(i + 1);
+            set_runend(en - 1, true);
+            set_runend(en, false);
+            hole = en;
+            qn++;
         }
+        rem(hole) = 0;
+        update_offsets(q, hole);
+        n_items--;
+    }
+
+    // Re-inserts the fingerprints of quotients [q_lo, q_hi) into dst, which
+    // has one more quotient bit: the top remainder bit joins the quotient
+    void move_quotients(size_t q_lo, size_t q_hi, QuotientFilter& dst) const {
+        const R low = (R)((1ULL << (rbits - 1)) - 1);
+        for (size_t q = q_lo; q < q_hi; q++) {
+            if (!occupied(q)) continue;
+            for (size_t s = run_start(q), e = last_runend(q); s <= e; s++) {
+                R r = blocks[s >> 6].rem[s & 63];
+                dst.insert_fp(q << 1 | r >> (rbits - 1), r & low);
+            }
+        }
+    }
+
+    size_t size() const { return n_items; }
+    size_t quotient_slots() const { return nslots; }
+    int remainder_bits() const { return rbits; }
+    size_t size_bytes() const override { return n_blocks * (sizeof(Block) + 1); }
+    size_t slots() const override { return nslots; } // MAX_LOAD applies to these
+    int fingerprint_bits() const override { return rbits; }
+};
+
+// ================================================================
+// 5. Auto-Growing Filters
+// Dynamic filters that start from a capacity hint and expand online,
+// never dropping a key.
+//   GrowingQuotientFilter  doubles the quotient space by moving one
+//                          remainder bit into the quotient. The copy to
+//                          the doubled table runs MOVE_STEP quotients
+//                          per insert; keys below the copy frontier
+//                          live in the new table. Each doubling costs
+//                          one remainder bit, so the FPR doubles.
+//   ScalableCuckooFilter   chains cuckoo filters; when the newest level
+//                          reaches the cuckoo target load a new one twice
+//                          as large with one more fingerprint bit (rounded
+//                          up to a stored width, at most 16) is added, so
+//                          nothing is ever rehashed. Past the 16-bit cap
+//                          each level adds about 2*BUCKET/2^16 to the FPR.
+// ================================================================
+template <typename R>
+class GrowingQuotientFilter : public Filter {
+    using QF = QuotientFilter<R>;
+    static constexpr double GROW_AT = 0.90; // load that starts a doubling
+    static const size_t MOVE_STEP = 64;     // old quotients copied per insert
+
+    unique_ptr<QF> cur, next; // next is non-null while a doubling is running
+    size_t frontier = 0;      // quotients of cur below this are in next
+
+    // The table that holds h: next once its old quotient has been copied
+    QF& table_for(uint64_t h) const {
+        if (!next) return *cur;
+        size_t q; R r;
+        cur->split(h, q, r);
+        return q < frontier ? *next : *cur;
+    }
+
+    void step() {
+        if (!next) {
+            if (cur->size() < GROW_AT * cur->quotient_slots()) return;
+            if (cur->remainder_bits() == 1) throw runtime_error("quotient filter: no remainder bits left to grow");
+            next.reset(new QF((size_t)(QF::MAX_LOAD * 2 * cur->quotient_slots()), cur->remainder_bits() - 1));
+            frontier = 0;
+        }
+        size_t hi = min(frontier + MOVE_STEP, cur->quotient_slots());
+        cur->move_quotients(frontier, hi, *next);
+        frontier = hi;
+        if (frontier == cur->quotient_slots()) {
+            cur = move(next);
+            frontier = 0;
+        }
+    }
+
+public:
+    GrowingQuotientFilter(size_t n_entries) : cur(new QF(n_entries)) {}
+
+    void insert(uint64_t key) override {
+        step();
+        table_for(hash64(key, 0)).insert(key);
+    }
+
+    bool query(uint64_t key) override { return table_for(hash64(key, 0)).query(key); }
+
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        if (!next) return cur->query_batch(keys, n, out);
+        Filter::query_batch(keys, n, out);
+    }
+
+    size_t count(uint64_t key) const { return table_for(hash64(key, 0)).count(key); }
+    void remove(uint64_t key) override { table_for(hash64(key, 0)).remove(key); }
+
+    // Saved as the current table (reopens as a fixed-size QuotientFilter);
+    // not while a doubling is running
+    bool image(FilterImage& im) const override { return !next && cur->image(im); }
+
+    size_t size_bytes() const override { return cur->size_bytes() + (next ? next->size_bytes() : 0); }
+};
+
+template <int BUCKET>
+Filter* cuckoo_from_image(const FilterImage& im);
+
+template <int BUCKET>
+class ScalableCuckooFilter : public Filter {
+    // The level directory, saved as the first image section
+    struct LevelInfo { uint64_t fp_bits, n_buckets, items, capacity; };
+    vector<unique_ptr<Filter>> levels;
+    vector<LevelInfo> info;
+    int fp_bits;
+
+    // Widest fingerprint a level grows to; the next native width is 32
+    static constexpr int MAX_FP_BITS = 16;
+
+    // The level is full when its real table is at the cuckoo target load
+    void add_level(size_t n_entries) {
+        int bits = min(fp_bits + (int)levels.size(), max(fp_bits, MAX_FP_BITS));
+        levels.emplace_back(make_cuckoo<BUCKET>(bits, n_entries));
+        size_t slots = levels.back()->slots();
+        info.push_back({(uint64_t)levels.back()->fingerprint_bits(), slots / BUCKET, 0,
+                        (uint64_t)(slots * CuckooFilter<8, BUCKET>::MAX_LOAD)});
+    }
+
+public:
+    ScalableCuckooFilter(size_t n_entries, int fp_bits) : fp_bits(fp_bits) {
+        add_level(max<size_t>(n_entries, 64));
+    }
+
+    // Each level is a cuckoo filter around its table and stash sections
+    ScalableCuckooFilter(const FilterImage& im) : fp_bits((int)im.params[1]) {
+        auto dir = (const LevelInfo*)im.sections[0].data;
+        info.assign(dir, dir + im.params[2]);
+        for (size_t i = 0; i < info.size(); i++) {
+            FilterImage level;
+            level.kind = KIND_CUCKOO;
+            level.params[0] = info[i].fp_bits; level.params[1] = BUCKET; level.params[3] = info[i].n_buckets;
+            level.add(im.sections[1 + 2 * i].data, im.sections[1 + 2 * i].bytes);
+            level.add(im.sections[2 + 2 * i].data, im.sections[2 + 2 * i].bytes);
+            levels.emplace_back(cuckoo_from_image<BUCKET>(level));
+            if (!levels.back()) throw runtime_error("scalable cuckoo filter: unknown level parameters");
+        }
+    }
+
+    // False once the levels outgrow the section table
+    bool image(FilterImage& im) const override {
+        if (1 + 2 * levels.size() > FilterImage::MAX_SECTIONS) return false;
+        im.kind = KIND_SCALABLE_CUCKOO;
+        im.params[0] = BUCKET; im.params[1] = fp_bits; im.params[2] = levels.size();
+        im.add(info.data(), info.size() * sizeof(info[0]));
+        for (auto& l : levels) {
+            FilterImage level;
+            l->image(level);
+            im.add(level.sections[0].data, level.sections[0].bytes);
+            im.add(level.sections[1].data, level.sections[1].bytes);
+        }
+        return true;
+    }
+
+    void insert(uint64_t key) override {
+        if (info.back().items >= info.back().capacity) add_level(2 * info.back().capacity);
+        levels.back()->insert(key);
+        info.back().items++;
+    }
+
+    bool query(uint64_t key) override {
+        for (auto& l : levels) if (l->query(key)) return true;
         return false;
     }
 
+    void query_batch(const uint64_t* keys, size_t n, uint8_t* out) override {
+        levels[0]->query_batch(keys, n, out);
+        vector<uint8_t> more(levels.size() > 1 ? n : 0);
+        for (size_t i = 1; i < levels.size(); i++) {
+            levels[i]->query_batch(keys, n, more.data());
+            for (size_t j = 0; j < n; j++) out[j] |= more[j];
+        }
+    }
+
+    // Only when exactly one level matches: if several do, all but one are
+    // false positives holding other keys' entries, and deleting the wrong
+    // one would lose that key. The entry stays behind as a false positive.
     void remove(uint64_t key) override {
-        uint64_t h = hash64(key, 0);
-        uint16_t r = h & ((1ULL << rbits) - 1);
-        for (auto &s : table) {
-            if ((s.meta & OCCUPIED) && s.remainder == r) {
-                s.meta = 0;
-                return;
-            }
+        size_t hit = levels.size();
+        for (size_t i = 0; i < levels.size(); i++) {
+            if (!levels[i]->query(key)) continue;
+            if (hit != levels.size()) return;
+            hit = i;
         }
+        if (hit == levels.size()) return;
+        levels[hit]->remove(key);
+        info[hit].items--;
     }
 
     size_t size_bytes() const override {
-        return table.size() * sizeof(Slot);
+        size_t b = 0;
+        for (auto& l : levels) b += l->size_bytes();
+        return b;
     }
+    int fingerprint_bits() const override { return levels.back()->fingerprint_bits(); } // newest level
+};
+
+// ================================================================
+// 6. On-Disk Format
+// A saved filter is a 4 KiB header followed by its data sections,
+// each starting on a 4 KiB boundary:
+//   magic "AMQFILT", format version, filter kind, 8 parameters
+//   (sizes, fingerprint widths, hash seeds), section offsets and
+//   lengths, a checksum of the sections and one of the header.
+// open_filter() maps the file privately (writes stay in memory) and
+// builds the filter around pointers into the mapping, so nothing is
+// read until a query touches it: open time and resident memory follow
+// the pages probed, not the filter size. The payload checksum is only
+// checked on request, since that reads every page.
+// ================================================================
+struct FilterFileHeader {
+    static const uint64_t PAGE = 4096;
+    static const uint32_t VERSION = 1;
+    char magic[8];
+    uint32_t version, kind;
+    uint64_t params[8];
+    uint64_t n_sections;
+    uint64_t section_offset[FilterImage::MAX_SECTIONS], section_bytes[FilterImage::MAX_SECTIONS];
+    uint64_t payload_checksum;
+    uint64_t header_checksum; // of every field above
 };
+static const char FILTER_MAGIC[8] = {'A', 'M', 'Q', 'F', 'I', 'L', 'T', 0};
 
+inline uint64_t header_checksum(const FilterFileHeader& h) {
+    return checksum64(&h, offsetof(FilterFileHeader, header_checksum));
+}
+
+inline uint64_t payload_checksum(const FilterImage& im) {
+    uint64_t c = 0;
+    for (int i = 0; i < im.n_sections; i++)
+        c = checksum64(im.sections[i].data, im.sections[i].bytes, c);
+    return c;
+}
+
+void save_filter(const Filter& f, const string& path) {
+    FilterImage im;
+    if (!f.image(im)) throw runtime_error("save_filter: filter has no on-disk format");
+
+    FilterFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FILTER_MAGIC, 8);
+    h.version = FilterFileHeader::VERSION;
+    h.kind = im.kind;
+    memcpy(h.params, im.params, sizeof(h.params));
+    h.n_sections = im.n_sections;
+    uint64_t off = FilterFileHeader::PAGE;
+    for (int i = 0; i < im.n_sections; i++) {
+        h.section_offset[i] = off;
+        h.section_bytes[i] = im.sections[i].bytes;
+        off += (im.sections[i].bytes + FilterFileHeader::PAGE - 1) / FilterFileHeader::PAGE * FilterFileHeader::PAGE;
+    }
+    h.payload_checksum = payload_checksum(im);
+    h.header_checksum = header_checksum(h);
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) throw runtime_error("save_filter: cannot create " + path);
+    vector<char> pad(FilterFileHeader::PAGE, 0);
+    out.write((const char*)&h, sizeof(h));
+    out.write(pad.data(), FilterFileHeader::PAGE - sizeof(h));
+    for (int i = 0; i < im.n_sections; i++) {
+        out.write((const char*)im.sections[i].data, im.sections[i].bytes);
+        out.write(pad.data(), (FilterFileHeader::PAGE - im.sections[i].bytes % FilterFileHeader::PAGE) % FilterFileHeader::PAGE);
+    }
+    if (!out.flush()) throw runtime_error("save_filter: write failed for " + path);
+}
+
+template <int BUCKET>
+Filter* cuckoo_from_image(const FilterImage& im) {
+    bool semi = im.params[2];
+    switch (im.params[0]) {
+    case 8:  return semi ? (Filter*)new CuckooFilter<8, BUCKET, BUCKET == 4>(im) : new CuckooFilter<8, BUCKET>(im);
+    case 12: return semi ? (Filter*)new CuckooFilter<12, BUCKET, BUCKET == 4>(im) : new CuckooFilter<12, BUCKET>(im);
+    case 16: return new CuckooFilter<16, BUCKET>(im);
+    case 32: return new CuckooFilter<32, BUCKET>(im);
+    }
+    return nullptr;
+}
+
+template <BloomLayout L>
+Filter* blocked_bloom_from_image(const FilterImage& im) {
+    return im.params[1] ? (Filter*)new BlockedBloomFilter<L, true>(im) : new BlockedBloomFilter<L>(im);
+}
+
+// Filter around the sections of an image, or nullptr for unknown parameters
+Filter* filter_from_image(const FilterImage& im) {
+    const uint64_t* p = im.params;
+    switch (im.kind) {
+    case KIND_BLOOM: return new BloomFilter(im);
+    case KIND_BLOCKED_BLOOM:
+        if (p[0] == (uint64_t)BloomLayout::Blocked512)    return blocked_bloom_from_image<BloomLayout::Blocked512>(im);
+        if (p[0] == (uint64_t)BloomLayout::Sectorized512) return blocked_bloom_from_image<BloomLayout::Sectorized512>(im);
+        if (p[0] == (uint64_t)BloomLayout::Register64)    return blocked_bloom_from_image<BloomLayout::Register64>(im);
+        return nullptr;
+    case KIND_XOR:
+        if (p[0] == 1) return new XORFilter<uint8_t>(im);
+        if (p[0] == 2) return new XORFilter<uint16_t>(im);
+        return nullptr;
+    case KIND_FUSE:
+        if (p[0] == 1 && p[1] == 3) return new BinaryFuseFilter<uint8_t, 3>(im);
+        if (p[0] == 1 && p[1] == 4) return new BinaryFuseFilter<uint8_t, 4>(im);
+        if (p[0] == 2 && p[1] == 3) return new BinaryFuseFilter<uint16_t, 3>(im);
+        if (p[0] == 2 && p[1] == 4) return new BinaryFuseFilter<uint16_t, 4>(im);
+        return nullptr;
+    case KIND_CUCKOO:
+        if (p[1] == 2) return cuckoo_from_image<2>(im);
+        if (p[1] == 4) return cuckoo_from_image<4>(im);
+        if (p[1] == 8) return cuckoo_from_image<8>(im);
+        return nullptr;
+    case KIND_QUOTIENT:
+        if (p[0] == 1) return new QuotientFilter<uint8_t>(im);
+        if (p[0] == 2) return new QuotientFilter<uint16_t>(im);
+        return nullptr;
+    case KIND_SCALABLE_CUCKOO:
+        if (p[0] != 4 || im.n_sections != (int)(1 + 2 * p[2]) || im.sections[0].bytes != p[2] * 4 * sizeof(uint64_t))
+            return nullptr;
+        return new ScalableCuckooFilter<4>(im);
+    }
+    return nullptr;
+}
+
+Filter* open_filter(const string& path, bool verify_checksum = false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("open_filter: cannot open " + path);
+    struct stat st;
+    fstat(fd, &st);
+    size_t len = st.st_size;
+    if (len < FilterFileHeader::PAGE) { close(fd); throw runtime_error("open_filter: " + path + " is truncated"); }
+    void* base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) throw runtime_error("open_filter: mmap failed for " + path);
+    shared_ptr<void> mapping(base, [len](void* p) { munmap(p, len); });
+    madvise(base, len, MADV_RANDOM); // probes are random: no readahead around them
+
+    const FilterFileHeader& h = *(const FilterFileHeader*)base;
+    if (memcmp(h.magic, FILTER_MAGIC, 8) != 0) throw runtime_error("open_filter: " + path + " is not a filter file");
+    if (h.version != FilterFileHeader::VERSION) throw runtime_error("open_filter: unsupported format version in " + path);
+    if (h.header_checksum != header_checksum(h)) throw runtime_error("open_filter: corrupt header in " + path);
+
+    FilterImage im;
+    im.kind = h.kind;
+    memcpy(im.params, h.params, sizeof(im.params));
+    if (h.n_sections > FilterImage::MAX_SECTIONS) throw runtime_error("open_filter: corrupt header in " + path);
+    for (uint64_t i = 0; i < h.n_sections; i++) {
+        if (h.section_offset[i] % FilterFileHeader::PAGE || h.section_offset[i] > len ||
+            h.section_bytes[i] > len - h.section_offset[i])
+            throw runtime_error("open_filter: " + path + " is truncated");
+        im.add((char*)base + h.section_offset[i], h.section_bytes[i]);
+    }
+    if (verify_checksum && payload_checksum(im) != h.payload_checksum)
+        throw runtime_error("open_filter: checksum mismatch in " + path);
+
+    Filter* f = filter_from_image(im);
+    if (!f) throw runtime_error("open_filter: unknown filter parameters in " + path);
+    f->backing = mapping;
+    return f;
+}
+
+// ================================================================
+// 7. Range Filter (Rosetta-style prefix Bloom hierarchy)
+// Level l is a blocked Bloom filter over the prefixes key >> l, for
+// l = 0 (whole keys) up to TOP. A range is split into aligned dyadic
+// intervals; each interval is checked at its level, and a positive
+// answer is confirmed by descending to both halves down to level 0,
+// so an upper-level false positive alone never reaches the caller.
+// Level 0 gets the target FPR; upper levels only prune descents and
+// get a looser one. Ranges wider than MAX_TOP intervals of 2^TOP keys
+// are not pruned.
+// ================================================================
+class RangeFilter : public Filter {
+    using Level = BlockedBloomFilter<BloomLayout::Blocked512>;
+    vector<unique_ptr<Level>> levels;
+    int top;
+
+    static uint64_t prefix_hash(uint64_t p, int l) { return hash64(p, 0x7a9e0000ULL + l); }
+
+    // Is some key with prefix p at level l (probably) present?
+    bool probe(int l, uint64_t p) const {
+        if (!levels[l]->test(prefix_hash(p, l))) return false;
+        return l == 0 || probe(l - 1, p << 1) || probe(l - 1, (p << 1) | 1);
+    }
+
+public:
+    static const int MAX_TOP = 64;
+
+    RangeFilter(size_t n_entries, double target_fpr, int range_bits = 16, double upper_fpr = 0.1)
+        : top(range_bits) {
+        for (int l = 0; l <= top; l++)
+            levels.emplace_back(new Level(n_entries, l == 0 ? target_fpr : upper_fpr));
+    }
+
+    void insert(uint64_t key) override {
+        for (int l = 0; l <= top; l++) levels[l]->set_bits(prefix_hash(key >> l, l));
+    }
+
+    bool query(uint64_t key) override { return levels[0]->test(prefix_hash(key, 0)); }
+
+    bool query_range(uint64_t lo, uint64_t hi) override {
+        if (lo > hi) return false;
+        int tops = 0;
+        for (uint64_t x = lo; ; ) {
+            // largest aligned interval starting at x that stays inside [lo, hi]
+            int l = x ? min(top, __builtin_ctzll(x)) : top;
+            while (l > 0 && hi - x < (1ULL << l) - 1) l--;
+            if (l == top && ++tops > MAX_TOP) return true;
+            if (probe(l, x >> l)) return true;
+            uint64_t last = x + ((1ULL << l) - 1);
+            if (last == hi) return false;
+            x = last + 1;
+        }
+    }
+
+    size_t size_bytes() const override {
+        size_t s = 0;
+        for (auto& lv : levels) s += lv->size_bytes();
+        return s;
+    }
+};
 
 // ================================================================
 // Export creation functions
 // ================================================================
-Filter* make_filter(const string& type, size_t n_entries, double fpr = 0.01) {
+// fp_bits = 0 picks the narrowest fingerprint that meets the target FPR
+Filter* make_filter(const string& type, size_t n_entries, double fpr = 0.01, int fp_bits = 0) {
+    bool wide = fp_bits ? fp_bits > 8 : fpr < 1.0 / 256;
     if (type == "bloom") return new BloomFilter(n_entries, fpr);
-    if (type == "xor")   return new XORFilter(n_entries);
-    if (type == "cuckoo")return new CuckooFilter(n_entries);
-    if (type == "quotient")return new QuotientFilter(n_entries);
+    if (type == "bloom_blocked")    return new BlockedBloomFilter<BloomLayout::Blocked512>(n_entries, fpr);
+    if (type == "bloom_sectorized") return new BlockedBloomFilter<BloomLayout::Sectorized512>(n_entries, fpr);
+    if (type == "bloom_register")   return new BlockedBloomFilter<BloomLayout::Register64>(n_entries, fpr);
+    if (type == "bloom_blocked_mt")    return new BlockedBloomFilter<BloomLayout::Blocked512, true>(n_entries, fpr);
+    if (type == "bloom_sectorized_mt") return new BlockedBloomFilter<BloomLayout::Sectorized512, true>(n_entries, fpr);
+    if (type == "bloom_register_mt")   return new BlockedBloomFilter<BloomLayout::Register64, true>(n_entries, fpr);
+    if (type == "xor")   return wide ? (Filter*)new XORFilter<uint16_t>(n_entries)
+                                     : (Filter*)new XORFilter<uint8_t>(n_entries);
+    if (type == "fuse3") return wide ? (Filter*)new BinaryFuseFilter<uint16_t, 3>(n_entries)
+                                     : (Filter*)new BinaryFuseFilter<uint8_t, 3>(n_entries);
+    if (type == "fuse4") return wide ? (Filter*)new BinaryFuseFilter<uint16_t, 4>(n_entries)
+                                     : (Filter*)new BinaryFuseFilter<uint8_t, 4>(n_entries);
+    // cuckoo FPR is about 2 * bucket / 2^fp_bits at full load
+    auto cbits = [&](int bucket) { return fp_bits ? fp_bits : (int)ceil(log2(2 * bucket / fpr)); };
+    if (type == "cuckoo")    return make_cuckoo<4>(cbits(4), n_entries);
+    if (type == "cuckoo2")   return make_cuckoo<2>(cbits(2), n_entries);
+    if (type == "cuckoo8")   return make_cuckoo<8>(cbits(8), n_entries);
+    if (type == "cuckoo_ss") return make_cuckoo<4, true>(cbits(4), n_entries);
+    if (type == "cuckoo_mt") return make_concurrent_cuckoo<4>(cbits(4), n_entries);
+    // quotient fp_bits are remainder bits, stored in the narrowest type that fits
+    if (type == "quotient") return wide ? (Filter*)new QuotientFilter<uint16_t>(n_entries, fp_bits ? min(fp_bits, 16) : 16)
+                                        : (Filter*)new QuotientFilter<uint8_t>(n_entries, fp_bits ? fp_bits : 8);
+    // growing filters take n_entries as the initial capacity; the quotient
+    // filter always starts with 16 remainder bits, enough for 15 doublings
+    if (type == "cuckoo_grow")   return new ScalableCuckooFilter<4>(n_entries, cbits(4));
+    if (type == "quotient_grow") return new GrowingQuotientFilter<uint16_t>(n_entries);
+    // range filter over ranges of up to 2^16 keys; query_range() prunes empty ranges
+    if (type == "range") return new RangeFilter(n_entries, fpr);
     return nullptr;
 }
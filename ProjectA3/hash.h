@@ -15,3 +15,84 @@ inline uint64_t mix64(uint64_t x) {
 inline uint64_t hash64(uint64_t key, uint64_t seed = 0) {
     return mix64(key + 0x9e3779b97f4a7c15ULL + seed * 0xbf58476d1ce4e5b9ULL);
 }
+
+// hash64 of n keys into out; same values as the scalar function. Uses 8
+// lanes with AVX-512DQ 64-bit multiplies, else 4 lanes with the multiply
+// built from three 32x32 products on AVX2, else a loop.
+#ifdef __AVX2__
+inline __m256i mullo64x4(__m256i a, __m256i b) {
+#if defined(__AVX512DQ__) && defined(__AVX512VL__)
+    return _mm256_mullo_epi64(a, b);
+#else
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+#endif
+}
+
+inline __m256i hash64x4(__m256i k, uint64_t seed) {
+    __m256i x = _mm256_add_epi64(k, _mm256_set1_epi64x(0x9e3779b97f4a7c15ULL + seed * 0xbf58476d1ce4e5b9ULL));
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+    x = mullo64x4(x, _mm256_set1_epi64x(0xff51afd7ed558ccdULL));
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+    x = mullo64x4(x, _mm256_set1_epi64x(0xc4ceb9fe1a85ec53ULL));
+    return _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+}
+#endif
+
+#ifdef __AVX512DQ__
+inline __m512i hash64x8(__m512i k, uint64_t seed) {
+    __m512i x = _mm512_add_epi64(k, _mm512_set1_epi64(0x9e3779b97f4a7c15ULL + seed * 0xbf58476d1ce4e5b9ULL));
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+    x = _mm512_mullo_epi64(x, _mm512_set1_epi64(0xff51afd7ed558ccdULL));
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+    x = _mm512_mullo_epi64(x, _mm512_set1_epi64(0xc4ceb9fe1a85ec53ULL));
+    return _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+}
+#endif
+
+inline void hash64x(const uint64_t* keys, size_t n, uint64_t seed, uint64_t* out) {
+    size_t i = 0;
+#ifdef __AVX512DQ__
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512((void*)(out + i), hash64x8(_mm512_loadu_si512((const void*)(keys + i)), seed));
+#endif
+#ifdef __AVX2__
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), hash64x4(_mm256_loadu_si256((const __m256i*)(keys + i)), seed));
+#endif
+    for (; i < n; i++) out[i] = hash64(keys[i], seed);
+}
+
+// Kirsch-Mitzenmacher double hashing: probe i is h1 + i * h2, so any
+// number of probes costs two base hashes (h2 is forced odd so probes
+// never repeat mod a power of two). Map probes with fastrange64.
+struct DoubleHash {
+    uint64_t h1, h2;
+    DoubleHash(uint64_t a, uint64_t b) : h1(a), h2(b | 1) {}
+    explicit DoubleHash(uint64_t key) : DoubleHash(hash64(key, 0), hash64(key, 1)) {}
+    uint64_t probe(uint64_t i) const { return h1 + i * h2; }
+};
+
+// Maps a 64-bit hash onto [0, n) with a multiply-shift instead of a modulo
+inline uint64_t fastrange64(uint64_t h, uint64_t n) {
+    return (uint64_t)(((__uint128_t)h * n) >> 64);
+}
+
+// Checksum of a byte range: four independent multiply-rotate lanes over
+// 8-byte words (about one word per cycle), folded with mix64
+inline uint64_t checksum64(const void* data, size_t bytes, uint64_t seed = 0) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t lane[4] = {seed, seed + 1, seed + 2, seed + 3}, w;
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+        for (int j = 0; j < 4; j++) {
+            __builtin_memcpy(&w, p + i + 8 * j, 8);
+            lane[j] = ((lane[j] ^ w) * 0x9e3779b97f4a7c15ULL);
+            lane[j] = lane[j] << 31 | lane[j] >> 33;
+        }
+    uint64_t h = mix64(lane[0] ^ mix64(lane[1] ^ mix64(lane[2] ^ mix64(lane[3] ^ bytes))));
+    for (; i < bytes; i++) h = mix64(h ^ p[i]);
+    return h;
+}
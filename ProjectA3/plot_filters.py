@@ -1,14 +1,18 @@
 #!/usr/bin/env python3
 """
 ECSE 4320 Project A3 — Approximate Membership Filters Analysis
-Updated version: handles multiple sizes, FPRs, workloads, neg_shares, load_factors, and thread counts.
+Reads the CSVs written by `./benchmark` (one row per loaded filter and thread
+count, plus one row per mixed-workload phase).
 
 Generates:
-1. Space vs Accuracy (BPE vs FPR_Target)
-2. Lookup Throughput vs Negative Lookup Share
-3. Insert Throughput vs Load Factor (Dynamic filters)
-4. Thread Scaling (Throughput vs Threads)
+1. Space vs Accuracy (BPE vs measured FPR)
+2. Positive vs negative lookup latency (mean, p99, p99.9)
+3. Insert cost vs Load Factor (Dynamic filters)
+4. Thread Scaling (Lookup throughput vs Threads)
 5. Optional scaling by dataset size
+6. Shared-filter speedup vs threads (results/scaling_results.csv)
+7. Mixed workloads: throughput vs negative lookup share
+8. Range queries: FPR and ns per query vs range width (results/range_results.csv)
 """
 
 import os
@@ -18,47 +22,53 @@ import matplotlib.pyplot as plt
 
 # === Settings ===
 RESULTS_FILE = "results/all_results.csv"
+WORKLOAD_FILE = "results/workload_results.csv"
+SCALING_FILE = "results/scaling_results.csv"
+RANGE_FILE = "results/range_results.csv"
 OUTPUT_DIR = "plots"
 os.makedirs(OUTPUT_DIR, exist_ok=True)
 
 # === Load & Prepare Data ===
 df = pd.read_csv(RESULTS_FILE)
-df["Query_throughput"] = df["N"] / df["Query_s"]
-df["Insert_throughput"] = df["N"] / df["Insert_s"]
+# per-op ns are per thread; throughput counts every thread
+df["Query_throughput"] = df["Threads"] * 1e9 / ((df["Pos_ns"] + df["Neg_ns"]) / 2)
 
 # Ensure consistent filter order
-filter_order = ["bloom", "xor", "cuckoo", "quotient"] if "quotient" in df["Filter"].unique() else ["bloom", "xor", "cuckoo"]
+filter_order = [f for f in ["bloom", "bloom_blocked", "xor", "fuse3", "cuckoo", "cuckoo_mt", "quotient"]
+                if f in df["Filter"].unique()]
 
 # Color map for filters
 colors = {
     "bloom": "#4C72B0",
+    "bloom_blocked": "#64B5CD",
     "xor": "#55A868",
+    "fuse3": "#8C8C3C",
     "cuckoo": "#C44E52",
+    "cuckoo_mt": "#DD8452",
     "quotient": "#8172B2",
 }
 
 # ============================================================
-# 1. Space vs Accuracy (BPE vs FPR_Target)
+# 1. Space vs Accuracy (BPE vs measured FPR)
 # ============================================================
 def plot_space_vs_accuracy():
     plt.figure(figsize=(8,6))
     for f in filter_order:
-        # skip Quotient filter
-        if f == "quotient" or f not in df["Filter"].unique():
-            continue
-        sub = df[df["Filter"] == f]
-        grouped = sub.groupby("FPR_Target", as_index=False)[["BPE", "FalsePosRate"]].mean()
+        sub = df[(df["Filter"] == f) & (df["Threads"] == df["Threads"].min())]
+        # one point per FPR target / fingerprint width, at the highest load reached
+        sub = sub.sort_values("LoadFactor").groupby(["FPR_Target", "FPBits"], as_index=False).last()
+        sub = sub[sub["FalsePosRate"] > 0].sort_values("BPE")
         plt.plot(
-            grouped["FalsePosRate"], 
-            grouped["BPE"], 
-            marker='o', 
-            label=f, 
+            sub["FalsePosRate"],
+            sub["BPE"],
+            marker='o',
+            label=f,
             color=colors.get(f, None)
         )
     plt.xscale("log")
-    plt.xlabel("False Positive Rate (log scale)", fontsize=11)
+    plt.xlabel("Measured False Positive Rate (log scale)", fontsize=11)
     plt.ylabel("Bits per Entry (BPE)", fontsize=11)
-    plt.title("Space vs Accuracy (Bloom, XOR, Cuckoo)", fontsize=13, weight="bold")
+    plt.title("Space vs Accuracy", fontsize=13, weight="bold")
     plt.legend()
     plt.grid(True, which="both", ls="--", alpha=0.5)
     plt.tight_layout()
@@ -68,39 +78,43 @@ def plot_space_vs_accuracy():
 
 
 # ============================================================
-# 2. Lookup Throughput vs Negative Lookup Share
+# 2. Positive vs Negative Lookup Latency
 # ============================================================
-def plot_lookup_throughput():
-    plt.figure(figsize=(8,6))
-    for f in filter_order:
-        sub = df[(df["Filter"] == f) & (df["Workload"] == "read-only")]
-        grouped = sub.groupby("NegShare", as_index=False)["Query_throughput"].mean()
-        plt.plot(grouped["NegShare"] * 100, grouped["Query_throughput"], marker='o', label=f, color=colors.get(f, None))
-    plt.xlabel("Negative Lookup Share (%)", fontsize=11)
-    plt.ylabel("Query Throughput (ops/s)", fontsize=11)
-    plt.title("Lookup Throughput vs Negative Lookup Share", fontsize=13, weight="bold")
-    plt.legend()
-    plt.grid(True, ls="--", alpha=0.5)
+def plot_lookup_latency():
+    sub = df[(df["Threads"] == 1) & (df["N"] == df["N"].max())]
+    fig, axes = plt.subplots(1, 3, figsize=(16,5))
+    for ax, (stat, title) in zip(axes, [("ns", "Mean (batched)"), ("p99", "p99 (single query)"),
+                                        ("p999", "p99.9 (single query)")]):
+        g = sub.groupby("Filter")[[f"Pos_{stat}", f"Neg_{stat}"]].mean().reindex(filter_order)
+        x = np.arange(len(g))
+        ax.bar(x - 0.2, g[f"Pos_{stat}"], 0.4, label="positive")
+        ax.bar(x + 0.2, g[f"Neg_{stat}"], 0.4, label="negative")
+        ax.set_xticks(x)
+        ax.set_xticklabels(g.index, rotation=30)
+        ax.set_ylabel("ns per lookup", fontsize=11)
+        ax.set_title(title, fontsize=13, weight="bold")
+        ax.legend()
+        ax.grid(True, axis="y", ls="--", alpha=0.5)
     plt.tight_layout()
-    plt.savefig(os.path.join(OUTPUT_DIR, "lookup_throughput.png"), dpi=200)
+    plt.savefig(os.path.join(OUTPUT_DIR, "lookup_latency.png"), dpi=200)
     plt.close()
-    print("✅ Saved: lookup_throughput.png")
+    print("✅ Saved: lookup_latency.png")
 
 # ============================================================
-# 3. Insert/Delete Throughput vs Load Factor (Dynamic Filters)
+# 3. Insert Cost vs Load Factor (Dynamic Filters)
 # ============================================================
 def plot_insert_delete_throughput():
     plt.figure(figsize=(8,6))
-    dynamic_filters = ["cuckoo", "quotient"]
+    dynamic_filters = ["cuckoo", "cuckoo_mt", "quotient"]
     for f in dynamic_filters:
         if f not in df["Filter"].unique():
             continue
-        sub = df[(df["Filter"] == f) & (df["Workload"] != "read-only")]
-        grouped = sub.groupby("LoadFactor", as_index=False)["Insert_throughput"].mean()
-        plt.plot(grouped["LoadFactor"], grouped["Insert_throughput"], marker='o', label=f, color=colors.get(f, None))
+        sub = df[(df["Filter"] == f) & (df["Threads"] == 1)]
+        grouped = sub.groupby("LoadFactor", as_index=False)["Insert_ns"].mean()
+        plt.plot(grouped["LoadFactor"], grouped["Insert_ns"], marker='o', label=f, color=colors.get(f, None))
     plt.xlabel("Load Factor", fontsize=11)
-    plt.ylabel("Insert Throughput (ops/s)", fontsize=11)
-    plt.title("Insert/Delete Throughput vs Load Factor (Dynamic Filters)", fontsize=13, weight="bold")
+    plt.ylabel("Mean Insert Cost while Filling (ns/op)", fontsize=11)
+    plt.title("Insert Cost vs Load Factor (Dynamic Filters)", fontsize=13, weight="bold")
     plt.legend()
     plt.grid(True, ls="--", alpha=0.5)
     plt.tight_layout()
@@ -109,17 +123,17 @@ def plot_insert_delete_throughput():
     print("✅ Saved: insert_delete_throughput.png")
 
 # ============================================================
-# 4. Thread Scaling (Throughput vs Threads)
+# 4. Thread Scaling (Lookup Throughput vs Threads)
 # ============================================================
 def plot_thread_scaling():
     plt.figure(figsize=(8,6))
     for f in filter_order:
-        sub = df[(df["Filter"] == f) & (df["Workload"] == "read-mostly")]
+        sub = df[df["Filter"] == f]
         grouped = sub.groupby("Threads", as_index=False)["Query_throughput"].mean()
         plt.plot(grouped["Threads"], grouped["Query_throughput"], marker='o', label=f, color=colors.get(f, None))
     plt.xlabel("Threads", fontsize=11)
-    plt.ylabel("Query Throughput (ops/s)", fontsize=11)
-    plt.title("Thread Scaling (Read-Mostly Workload)", fontsize=13, weight="bold")
+    plt.ylabel("Lookup Throughput (ops/s)", fontsize=11)
+    plt.title("Thread Scaling (Half Positive, Half Negative)", fontsize=13, weight="bold")
     plt.legend()
     plt.grid(True, ls="--", alpha=0.5)
     plt.tight_layout()
@@ -133,12 +147,12 @@ def plot_thread_scaling():
 def plot_size_scaling():
     plt.figure(figsize=(8,6))
     for f in filter_order:
-        sub = df[(df["Filter"] == f) & (df["Workload"] == "read-only") & (df["NegShare"] == 0)]
-        grouped = sub.groupby("N", as_index=False)["Query_throughput"].mean()
-        plt.plot(grouped["N"] / 1e6, grouped["Query_throughput"], marker='o', label=f, color=colors.get(f, None))
+        sub = df[(df["Filter"] == f) & (df["Threads"] == 1)]
+        grouped = sub.groupby("N", as_index=False)["Pos_ns"].mean()
+        plt.plot(grouped["N"] / 1e6, 1e9 / grouped["Pos_ns"], marker='o', label=f, color=colors.get(f, None))
     plt.xlabel("Dataset Size (Million Keys)", fontsize=11)
-    plt.ylabel("Query Throughput (ops/s)", fontsize=11)
-    plt.title("Throughput vs Dataset Size (Read-Only, No Negatives)", fontsize=13, weight="bold")
+    plt.ylabel("Positive Lookup Throughput (ops/s)", fontsize=11)
+    plt.title("Throughput vs Dataset Size (One Thread)", fontsize=13, weight="bold")
     plt.legend()
     plt.grid(True, ls="--", alpha=0.5)
     plt.tight_layout()
@@ -146,14 +160,99 @@ def plot_size_scaling():
     plt.close()
     print("✅ Saved: throughput_vs_size.png")
 
+# ============================================================
+# 6. Shared-Filter Speedup vs Threads
+# ============================================================
+def plot_scaling_speedup():
+    if not os.path.exists(SCALING_FILE):
+        return
+    sc = pd.read_csv(SCALING_FILE)
+    fig, axes = plt.subplots(1, 2, figsize=(14,6))
+    for col, ax, title in [("Insert_Speedup", axes[0], "Concurrent Inserts"),
+                           ("Query_Speedup", axes[1], "Queries")]:
+        for f in sc["Filter"].unique():
+            sub = sc[(sc["Filter"] == f) & sc[col].notna()]
+            if sub.empty:
+                continue
+            ax.plot(sub["Threads"], sub[col], marker='o', label=f)
+        threads = sorted(sc["Threads"].unique())
+        ax.plot(threads, threads, ls=":", color="gray", label="linear")
+        ax.set_xlabel("Threads", fontsize=11)
+        ax.set_ylabel("Speedup vs 1 thread", fontsize=11)
+        ax.set_title(f"{title} on One Shared Filter", fontsize=13, weight="bold")
+        ax.legend()
+        ax.grid(True, ls="--", alpha=0.5)
+    plt.tight_layout()
+    plt.savefig(os.path.join(OUTPUT_DIR, "shared_filter_scaling.png"), dpi=200)
+    plt.close()
+    print("✅ Saved: shared_filter_scaling.png")
+
+# ============================================================
+# 7. Mixed Workloads: Throughput vs Negative Lookup Share
+# ============================================================
+def plot_mixed_workloads():
+    if not os.path.exists(WORKLOAD_FILE):
+        return
+    wl = pd.read_csv(WORKLOAD_FILE)
+    wl = wl[wl["Threads"] == 1]
+    workloads = list(wl["Workload"].unique())
+    if not workloads:
+        return
+    fig, axes = plt.subplots(1, len(workloads), figsize=(7 * len(workloads), 6), squeeze=False)
+    for ax, w in zip(axes[0], workloads):
+        for f in wl["Filter"].unique():
+            sub = wl[(wl["Filter"] == f) & (wl["Workload"] == w)]
+            grouped = sub.groupby("NegShare", as_index=False)["Mops"].mean()
+            ax.plot(grouped["NegShare"] * 100, grouped["Mops"], marker='o', label=f, color=colors.get(f, None))
+        ax.set_xlabel("Negative Lookup Share (%)", fontsize=11)
+        ax.set_ylabel("Throughput (Mops/s)", fontsize=11)
+        ax.set_title(f"{w} (updates keep the load factor fixed)", fontsize=13, weight="bold")
+        ax.legend()
+        ax.grid(True, ls="--", alpha=0.5)
+    plt.tight_layout()
+    plt.savefig(os.path.join(OUTPUT_DIR, "mixed_workloads.png"), dpi=200)
+    plt.close()
+    print("✅ Saved: mixed_workloads.png")
+
+# ============================================================
+# 8. Range Queries vs Range Width
+# ============================================================
+def plot_range_queries():
+    if not os.path.exists(RANGE_FILE):
+        return
+    rq = pd.read_csv(RANGE_FILE)
+    rq = rq[rq["N"] == rq["N"].max()]
+    fig, axes = plt.subplots(1, 2, figsize=(14,6))
+    for f in rq["Filter"].unique():
+        sub = rq[rq["Filter"] == f].sort_values("Width")
+        label = f"{f} ({sub['BPE'].iloc[0]:.0f} bits/key)"
+        axes[0].plot(sub["Width"], sub["RangeFPR"], marker='o', label=label, color=colors.get(f, None))
+        axes[1].plot(sub["Width"], sub["Empty_ns"], marker='o', label=label, color=colors.get(f, None))
+    for ax, ylabel, title in [(axes[0], "False Positive Rate (empty ranges)", "Range FPR vs Width"),
+                              (axes[1], "ns per Range Query (empty ranges)", "Range Query Cost vs Width")]:
+        ax.set_xscale("log", base=2)
+        ax.set_yscale("log")
+        ax.set_xlabel("Range Width (keys)", fontsize=11)
+        ax.set_ylabel(ylabel, fontsize=11)
+        ax.set_title(title, fontsize=13, weight="bold")
+        ax.legend()
+        ax.grid(True, which="both", ls="--", alpha=0.5)
+    plt.tight_layout()
+    plt.savefig(os.path.join(OUTPUT_DIR, "range_queries.png"), dpi=200)
+    plt.close()
+    print("✅ Saved: range_queries.png")
+
 # ============================================================
 # Main
 # ============================================================
 if __name__ == "__main__":
     print(f"Loaded {len(df)} rows from {RESULTS_FILE}")
     plot_space_vs_accuracy()
-    plot_lookup_throughput()
+    plot_lookup_latency()
     plot_insert_delete_throughput()
     plot_thread_scaling()
     plot_size_scaling()
+    plot_scaling_speedup()
+    plot_mixed_workloads()
+    plot_range_queries()
     print("✅ All plots generated in ./plots/")
@@ -7,37 +7,98 @@
 #include <vector>
 #include <list>
 #include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <optional>
 #include <thread>
 #include <random>
 #include <chrono>
 #include <atomic>
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#include <pthread.h>
+#include <sched.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using Key = int;
 using Value = int;
 
 // ===================== Hash Tables =====================
 
+// Chained tables keep one entry per key: insert() updates an existing
+// key's value instead of appending a duplicate
+
 // 1. Coarse-Grained Lock
+// Grows by incremental rehash: past MAX_LOAD entries per bucket a table
+// twice as large is allocated, and every later operation moves
+// MIGRATE_STEP old buckets into it before doing its own work.
 class CoarseHashTable {
 private:
-    std::vector<std::list<std::pair<Key, Value>>> table;
+    using Chain = std::list<std::pair<Key, Value>>;
+    std::vector<Chain> table;
+    std::vector<Chain> next_table; // non-empty while migrating
     size_t n_buckets;
+    size_t migrated = 0;           // old buckets already moved to next_table
+    size_t n_items = 0;
     std::mutex global_mutex;
+    static constexpr double MAX_LOAD = 1.0;
+    static const size_t MIGRATE_STEP = 4;
+
+    Chain &chain_of(Key key) {
+        size_t idx = key % n_buckets;
+        if (idx < migrated) return next_table[key % next_table.size()];
+        return table[idx];
+    }
+
+    void migrate_step() {
+        if (next_table.empty()) return;
+        for (size_t s = 0; s < MIGRATE_STEP && migrated < n_buckets; s++, migrated++) {
+            Chain &old = table[migrated];
+            while (!old.empty()) {
+                Chain &dst = next_table[old.front().first % next_table.size()];
+                dst.splice(dst.end(), old, old.begin()); // relinks the node, no allocation
+            }
+        }
+        if (migrated == n_buckets) {
+            table.swap(next_table);
+            n_buckets = table.size();
+            std::vector<Chain>().swap(next_table);
+            migrated = 0;
+        }
+    }
 
 public:
-    CoarseHashTable(size_t buckets) : n_buckets(buckets), table(buckets) {}
+    CoarseHashTable(size_t buckets) : table(buckets), n_buckets(buckets) {}
 
     void insert(Key key, Value value) {
         std::lock_guard<std::mutex> lock(global_mutex);
-        size_t idx = key % n_buckets;
-        table[idx].emplace_back(key, value);
+        migrate_step();
+        Chain &chain = chain_of(key);
+        for (auto &kv : chain) {
+            if (kv.first == key) {
+                kv.second = value;
+                return;
+            }
+        }
+        chain.emplace_back(key, value);
+        if (++n_items > MAX_LOAD * n_buckets && next_table.empty())
+            next_table.resize(2 * n_buckets);
     }
 
     bool find(Key key, Value &value) {
         std::lock_guard<std::mutex> lock(global_mutex);
-        size_t idx = key % n_buckets;
-        for (auto &kv : table[idx]) {
+        migrate_step();
+        for (auto &kv : chain_of(key)) {
             if (kv.first == key) {
                 value = kv.second;
                 return true;
@@ -48,31 +109,121 @@ public:
 
     void erase(Key key) {
         std::lock_guard<std::mutex> lock(global_mutex);
-        size_t idx = key % n_buckets;
-        table[idx].remove_if([key](auto &kv){ return kv.first == key; });
+        migrate_step();
+        Chain &chain = chain_of(key);
+        size_t before = chain.size();
+        chain.remove_if([key](auto &kv){ return kv.first == key; });
+        n_items -= before - chain.size();
     }
 };
 
-// 2. Fine-Grained Lock (One mutex per bucket)
+// 2. Fine-Grained Lock (One mutex per bucket to start)
+// The mutex array is fixed when the table is built, one per initial
+// bucket, and bucket i is guarded by mutex i % n_mutexes. Bucket counts
+// are powers of two, so when the table doubles, old bucket i splits into
+// buckets i and i + n under the same mutex. Growth is incremental as in
+// CoarseHashTable, without the global lock: once some mutex's share of
+// the keys passes MAX_LOAD per bucket, a table twice as large is linked
+// as the successor, and every later insert and erase claims MIGRATE_STEP
+// old buckets and splices their chains over under their mutex. A moved
+// bucket is flagged, and operations on its keys go on to the successor.
+// Retired tables (by then vectors of empty chains) stay allocated until
+// the table is destroyed, since a thread may still be about to look in one.
 class FineHashTable {
 private:
-    std::vector<std::list<std::pair<Key, Value>>> table;
+    using Chain = std::list<std::pair<Key, Value>>;
+    struct Table {
+        std::vector<Chain> chains;
+        std::vector<uint8_t> moved; // per bucket, written and read under its mutex
+        size_t mask;
+        std::atomic<Table*> successor{nullptr};
+        std::atomic<size_t> claimed{0}, done{0};
+        Table(size_t n) : chains(n), moved(n), mask(n - 1) {}
+    };
+    static constexpr double MAX_LOAD = 1.0;
+    static const size_t MIGRATE_STEP = 4;
+
     std::vector<std::mutex> bucket_mutexes;
-    size_t n_buckets;
+    std::vector<size_t> items; // keys under each mutex, guarded by it
+    size_t mutex_mask;
+    std::atomic<Table*> current;
+    std::vector<std::unique_ptr<Table>> tables; // every table ever created
+    std::mutex tables_mutex;
+
+    // Key's chain, following moved buckets into successor tables; the
+    // caller holds the key's mutex
+    static Chain &chain_of(Table *t, Key key) {
+        while (t->moved[size_t(key) & t->mask]) t = t->successor.load(std::memory_order_acquire);
+        return t->chains[size_t(key) & t->mask];
+    }
+
+    // Links a table twice as large unless a migration is already running
+    void start_grow(Table *t) {
+        if (t->successor.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(tables_mutex);
+        if (t->successor.load(std::memory_order_relaxed) || current.load(std::memory_order_acquire) != t) return;
+        tables.emplace_back(new Table(2 * (t->mask + 1)));
+        t->successor.store(tables.back().get(), std::memory_order_release);
+    }
+
+    // Moves up to MIGRATE_STEP unclaimed buckets of the current table
+    void help_migrate() {
+        Table *t = current.load(std::memory_order_acquire);
+        Table *nt = t->successor.load(std::memory_order_acquire);
+        if (!nt) return;
+        size_t n = t->mask + 1;
+        size_t lo = t->claimed.fetch_add(MIGRATE_STEP, std::memory_order_relaxed);
+        if (lo >= n) return;
+        size_t hi = std::min(n, lo + MIGRATE_STEP);
+        for (size_t i = lo; i < hi; i++) {
+            std::lock_guard<std::mutex> lock(bucket_mutexes[i & mutex_mask]);
+            Chain &old = t->chains[i];
+            while (!old.empty()) {
+                Chain &dst = nt->chains[size_t(old.front().first) & nt->mask];
+                dst.splice(dst.end(), old, old.begin()); // relinks the node, no allocation
+            }
+            t->moved[i] = 1;
+        }
+        if (t->done.fetch_add(hi - lo, std::memory_order_acq_rel) + (hi - lo) == n)
+            current.store(nt, std::memory_order_release);
+    }
 
 public:
-    FineHashTable(size_t buckets) : n_buckets(buckets), table(buckets), bucket_mutexes(buckets) {}
+    // buckets is rounded up to a power of two and fixes the mutex count
+    FineHashTable(size_t buckets) {
+        size_t b = 1;
+        while (b < buckets) b *= 2;
+        bucket_mutexes = std::vector<std::mutex>(b);
+        items.assign(b, 0);
+        mutex_mask = b - 1;
+        tables.emplace_back(new Table(b));
+        current.store(tables.back().get());
+    }
 
     void insert(Key key, Value value) {
-        size_t idx = key % n_buckets;
-        std::lock_guard<std::mutex> lock(bucket_mutexes[idx]);
-        table[idx].emplace_back(key, value);
+        help_migrate();
+        size_t m = size_t(key) & mutex_mask;
+        Table *t = current.load(std::memory_order_acquire);
+        bool grow;
+        {
+            std::lock_guard<std::mutex> lock(bucket_mutexes[m]);
+            Chain &chain = chain_of(t, key);
+            for (auto &kv : chain) {
+                if (kv.first == key) {
+                    kv.second = value;
+                    return;
+                }
+            }
+            chain.emplace_back(key, value);
+            // this mutex's keys against its share of the buckets
+            grow = ++items[m] > MAX_LOAD * (t->mask + 1) / bucket_mutexes.size();
+        }
+        if (grow) start_grow(t);
     }
 
     bool find(Key key, Value &value) {
-        size_t idx = key % n_buckets;
-        std::lock_guard<std::mutex> lock(bucket_mutexes[idx]);
-        for (auto &kv : table[idx]) {
+        std::lock_guard<std::mutex> lock(bucket_mutexes[size_t(key) & mutex_mask]);
+        for (auto &kv : chain_of(current.load(std::memory_order_acquire), key)) {
             if (kv.first == key) {
                 value = kv.second;
                 return true;
@@ -82,124 +233,1249 @@ public:
     }
 
     void erase(Key key) {
-        size_t idx = key % n_buckets;
-        std::lock_guard<std::mutex> lock(bucket_mutexes[idx]);
-        table[idx].remove_if([key](auto &kv){ return kv.first == key; });
+        help_migrate();
+        size_t m = size_t(key) & mutex_mask;
+        std::lock_guard<std::mutex> lock(bucket_mutexes[m]);
+        Chain &chain = chain_of(current.load(std::memory_order_acquire), key);
+        size_t before = chain.size();
+        chain.remove_if([key](auto &kv){ return kv.first == key; });
+        items[m] -= before - chain.size();
     }
+
+    size_t bucket_count() { return current.load(std::memory_order_acquire)->mask + 1; }
 };
 
-// ===================== Benchmark Utilities =====================
-enum class WorkloadType { LookupOnly, InsertOnly, Mixed7030 };
+// 3. Lock-Free Open Addressing
+// Slots are one 64-bit word (key in the high half, value in the low half)
+// packed 7 to a 64-byte group next to the group's state word; a key probes
+// its home group, then the following groups (linear probing). find() is
+// plain atomic loads. insert() claims an empty slot with one CAS. A slot's
+// key never changes once set, so two inserts of one key always meet at the
+// same slot; erase() replaces the value with a tombstone and a later insert
+// of the same key revives it. EMPTY_KEY and TOMBSTONE are reserved.
+//
+// Growth: per-chunk counters track claimed and tombstoned slots. When a
+// chunk passes MAX_LOAD claimed, a successor is linked: twice as large, or
+// the same size when most claimed slots are tombstones, which the copy drops.
+// Every insert and erase then claims MIGRATE_STEP groups. Each group is
+// frozen, drained of registered writers, copied (insert-if-absent) and
+// marked copied. Writers register in a group's state word before touching
+// its slots; one that finds the group frozen waits until it is copied and
+// continues in the successor, where an erase leaves a tombstone so the
+// copy of a later group cannot bring the key back. Readers go on to the
+// successor at the first copied group of their probe. Retired tables stay
+// allocated until the table is destroyed.
+class OpenHashTable {
+public:
+    static constexpr Key EMPTY_KEY = std::numeric_limits<Key>::min();
+    static constexpr Value TOMBSTONE = std::numeric_limits<Value>::min();
+    static constexpr size_t GROUP = 7; // slots per cache line, after the state word
 
-template<typename Table>
-void run_workload(Table &table, WorkloadType workload,
-                  const std::vector<Key> &keys,
-                  size_t start_idx, size_t end_idx,
-                  std::atomic<size_t> &ops_done) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-    size_t total = end_idx - start_idx;
-    size_t mixed_writes = 0;
-    if (workload == WorkloadType::Mixed7030)
-        mixed_writes = total * 0.3;
-
-    for (size_t i = start_idx; i < end_idx; i++) {
-        if (workload == WorkloadType::InsertOnly) {
-            table.insert(keys[i], keys[i]*2);
-        } else if (workload == WorkloadType::LookupOnly) {
-            Value val;
-            table.find(keys[i], val);
-        } else { // Mixed 70/30
-            if (i - start_idx < mixed_writes) {
-                table.insert(keys[i], keys[i]*2);
+private:
+    static constexpr uint64_t FROZEN = 1, COPIED = 2, WRITER = 4; // state word: flags + writers * WRITER
+    static constexpr double MAX_LOAD = 0.5;
+    static constexpr size_t CHUNK = 64;   // groups per claimed-slot counter
+    static const size_t MIGRATE_STEP = 16;
+
+    struct alignas(64) Group {
+        std::atomic<uint64_t> state;
+        std::atomic<uint64_t> slot[GROUP];
+    };
+    struct alignas(64) Chunk {
+        std::atomic<size_t> used{0}, dead{0}; // claimed slots, tombstones among them
+    };
+    struct Table {
+        std::vector<Group> groups;
+        std::vector<Chunk> chunks;
+        size_t mask;
+        int shift;
+        size_t chunk_slots;
+        std::atomic<Table*> successor{nullptr};
+        std::atomic<size_t> claimed{0}, moved{0};
+
+        Table(size_t n_groups) : groups(n_groups), chunks((n_groups + CHUNK - 1) / CHUNK), mask(n_groups - 1) {
+            shift = 64 - __builtin_ctzll(n_groups);
+            if (n_groups == 1) shift = 63; // home() must still return 0
+            chunk_slots = std::min(CHUNK, n_groups) * GROUP;
+            for (auto &g : groups)
+                for (auto &s : g.slot) s.store(pack(EMPTY_KEY, 0), std::memory_order_relaxed);
+        }
+        // Fibonacci hashing: the top bits of key * 2^64/phi pick the home group
+        size_t home(Key key) const { return size_t((uint64_t(uint32_t(key)) * 0x9E3779B97F4A7C15ULL) >> shift) & mask; }
+        Chunk &chunk_of(size_t gi) { return chunks[gi / CHUNK]; }
+    };
+
+    std::atomic<Table*> current;
+    std::vector<std::unique_ptr<Table>> tables; // every table ever created
+    std::mutex tables_mutex;
+
+    static uint64_t pack(Key k, Value v) { return (uint64_t(uint32_t(k)) << 32) | uint32_t(v); }
+    static Key key_of(uint64_t w) { return Key(uint32_t(w >> 32)); }
+    static Value value_of(uint64_t w) { return Value(uint32_t(w)); }
+
+    // Registers a writer on g; fails, unregistered, once g is frozen
+    static bool enter(Group &g) {
+        if (!(g.state.fetch_add(WRITER, std::memory_order_acq_rel) & FROZEN)) return true;
+        g.state.fetch_sub(WRITER, std::memory_order_release);
+        return false;
+    }
+    static void leave(Group &g) { g.state.fetch_sub(WRITER, std::memory_order_release); }
+    static void wait_copied(Group &g) {
+        while (!(g.state.load(std::memory_order_acquire) & COPIED)) std::this_thread::yield();
+    }
+
+    // Replaces the value of a claimed slot, keeping the chunk's tombstone count exact
+    static void overwrite(Table *t, size_t gi, std::atomic<uint64_t> &s, uint64_t w, Key key, Value value) {
+        while (!s.compare_exchange_weak(w, pack(key, value), std::memory_order_acq_rel)) {}
+        bool was_dead = value_of(w) == TOMBSTONE, is_dead = value == TOMBSTONE;
+        if (was_dead != is_dead) {
+            if (is_dead) t->chunk_of(gi).dead.fetch_add(1, std::memory_order_relaxed);
+            else t->chunk_of(gi).dead.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Upserts key into t, or with if_absent only adds it; follows frozen groups to successors
+    void put(Table *t, Key key, Value value, bool if_absent) {
+        for (;;) {
+            size_t gi = t->home(key);
+            bool redirected = false;
+            for (size_t probed = 0; probed <= t->mask && !redirected; probed++, gi = (gi + 1) & t->mask) {
+                Group &g = t->groups[gi];
+                if (!enter(g)) {
+                    wait_copied(g);
+                    redirected = true;
+                    break;
+                }
+                for (auto &s : g.slot) {
+                    uint64_t w = s.load(std::memory_order_acquire);
+                    if (key_of(w) == EMPTY_KEY &&
+                        s.compare_exchange_strong(w, pack(key, value), std::memory_order_acq_rel)) {
+                        leave(g);
+                        Chunk &c = t->chunk_of(gi);
+                        if (value == TOMBSTONE) c.dead.fetch_add(1, std::memory_order_relaxed);
+                        if (c.used.fetch_add(1, std::memory_order_relaxed) + 1 > MAX_LOAD * t->chunk_slots)
+                            start_grow(t);
+                        return;
+                    }
+                    // on a lost race w now holds the winner; it may be this key
+                    if (key_of(w) == key) {
+                        if (!if_absent) overwrite(t, gi, s, w, key, value);
+                        leave(g);
+                        return;
+                    }
+                }
+                leave(g);
+            }
+            if (!redirected) throw std::runtime_error("OpenHashTable: table full");
+            t = t->successor.load(std::memory_order_acquire);
+        }
+    }
+
+    // Links a successor unless a migration is already running: twice the
+    // size, or the same size when tombstones make up most claimed slots
+    void start_grow(Table *t) {
+        if (t->successor.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(tables_mutex);
+        if (t->successor.load(std::memory_order_relaxed) || current.load(std::memory_order_acquire) != t) return;
+        size_t live = 0, n_groups = t->mask + 1;
+        for (auto &c : t->chunks)
+            live += c.used.load(std::memory_order_relaxed) - c.dead.load(std::memory_order_relaxed);
+        if (live > MAX_LOAD / 2 * n_groups * GROUP) n_groups *= 2;
+        tables.emplace_back(new Table(n_groups));
+        t->successor.store(tables.back().get(), std::memory_order_release);
+    }
+
+    // Copies up to MIGRATE_STEP unclaimed groups of the current table
+    void help_migrate() {
+        Table *t = current.load(std::memory_order_acquire);
+        Table *nt = t->successor.load(std::memory_order_acquire);
+        if (!nt) return;
+        size_t n = t->mask + 1;
+        size_t lo = t->claimed.fetch_add(MIGRATE_STEP, std::memory_order_relaxed);
+        if (lo >= n) return;
+        size_t hi = std::min(n, lo + MIGRATE_STEP);
+        for (size_t i = lo; i < hi; i++) {
+            Group &g = t->groups[i];
+            g.state.fetch_or(FROZEN, std::memory_order_acq_rel);
+            while (g.state.load(std::memory_order_acquire) >= WRITER) std::this_thread::yield();
+            for (auto &s : g.slot) {
+                uint64_t w = s.load(std::memory_order_relaxed);
+                if (key_of(w) != EMPTY_KEY && value_of(w) != TOMBSTONE)
+                    put(nt, key_of(w), value_of(w), true);
+            }
+            g.state.fetch_or(COPIED, std::memory_order_release);
+        }
+        if (t->moved.fetch_add(hi - lo, std::memory_order_acq_rel) + (hi - lo) == n)
+            current.store(nt, std::memory_order_release);
+    }
+
+public:
+    // Sized so `capacity` keys fill at most half of the slots
+    OpenHashTable(size_t capacity) {
+        size_t n_groups = 1;
+        while (n_groups * GROUP < 2 * capacity) n_groups *= 2;
+        tables.emplace_back(new Table(n_groups));
+        current.store(tables.back().get());
+    }
+
+    // Inserts the key, or updates its value if it is already present
+    void insert(Key key, Value value) {
+        help_migrate();
+        put(current.load(std::memory_order_acquire), key, value, false);
+    }
+
+    bool find(Key key, Value &value) {
+        Table *t = current.load(std::memory_order_acquire);
+        for (;;) {
+            size_t gi = t->home(key);
+            bool moved = false;
+            for (size_t probed = 0; probed <= t->mask && !moved; probed++, gi = (gi + 1) & t->mask) {
+                Group &g = t->groups[gi];
+                if (g.state.load(std::memory_order_acquire) & COPIED) {
+                    moved = true;
+                    break;
+                }
+                for (auto &s : g.slot) {
+                    uint64_t w = s.load(std::memory_order_acquire);
+                    if (key_of(w) == key) {
+                        if (value_of(w) == TOMBSTONE) return false;
+                        value = value_of(w);
+                        return true;
+                    }
+                    if (key_of(w) == EMPTY_KEY) return false; // keys are never moved past an empty slot
+                }
+            }
+            if (!moved) return false;
+            t = t->successor.load(std::memory_order_acquire);
+        }
+    }
+
+    void erase(Key key) {
+        help_migrate();
+        Table *t = current.load(std::memory_order_acquire);
+        size_t gi = t->home(key);
+        for (size_t probed = 0; probed <= t->mask; probed++, gi = (gi + 1) & t->mask) {
+            Group &g = t->groups[gi];
+            if (!enter(g)) {
+                // the key may sit in a group not copied yet: a tombstone keeps that copy out
+                wait_copied(g);
+                put(t->successor.load(std::memory_order_acquire), key, TOMBSTONE, false);
+                return;
+            }
+            for (auto &s : g.slot) {
+                uint64_t w = s.load(std::memory_order_acquire);
+                if (key_of(w) == key) {
+                    overwrite(t, gi, s, w, key, TOMBSTONE);
+                    leave(g);
+                    return;
+                }
+                if (key_of(w) == EMPTY_KEY) {
+                    leave(g);
+                    return;
+                }
+            }
+            leave(g);
+        }
+    }
+
+    size_t group_count() { return current.load(std::memory_order_acquire)->mask + 1; }
+};
+
+// 4. Striped Locks with Reader-Optimized Lookups
+// Key k lives in bucket hash(k) % n_buckets and is guarded by stripe
+// hash(k) % n_stripes; each stripe sits on its own cache line, so neighboring
+// stripes never false-share. Writers take the stripe's shared_mutex
+// exclusively. Readers either
+//   Shared:     take it shared (readers of one stripe still bounce its line), or
+//   Optimistic: read the stripe's seqlock counter, walk the chain, and retry
+//               if the counter moved; no shared memory is written. After
+//               OPTIMISTIC_TRIES failures the read falls back to Shared.
+// Chains are singly linked nodes with atomic fields that are only freed
+// with the table: erased nodes go on the stripe's free list and are reused
+// by its later inserts, so an optimistic reader never touches freed memory
+// (and checks the counter on every step, so a reused node cannot loop it).
+//
+// Growth: bucket counts are powers of two and multiples of the stripe
+// count, so old bucket i splits into new buckets i and i + n, which share
+// its stripe. When a stripe's share of the keys passes MAX_LOAD per bucket,
+// a table twice as large is linked as the successor. Every insert and
+// erase then claims MIGRATE_STEP old buckets and moves them under their
+// stripe's lock, leaving MOVED in the old head; operations that find
+// MOVED continue in the successor. The thread moving the last bucket
+// publishes the successor as current. Retired tables stay allocated until
+// the table is destroyed, since optimistic readers may still walk them.
+enum class ReadMode { Shared, Optimistic };
+
+template<ReadMode MODE>
+class StripedHashTable {
+private:
+    struct Node {
+        std::atomic<Key> key;
+        std::atomic<Value> value;
+        std::atomic<Node*> next;
+    };
+    struct alignas(64) Stripe {
+        std::shared_mutex lock;
+        std::atomic<uint64_t> seq{0}; // odd while a writer is changing a chain
+        Node *free_list = nullptr;
+        size_t items = 0;
+    };
+    struct Table {
+        std::vector<std::atomic<Node*>> heads;
+        size_t mask;
+        std::atomic<Table*> successor{nullptr};
+        std::atomic<size_t> claimed{0}, moved{0};
+        Table(size_t n) : heads(n), mask(n - 1) {}
+    };
+    static const int OPTIMISTIC_TRIES = 4;
+    static constexpr double MAX_LOAD = 1.0;
+    static const size_t MIGRATE_STEP = 8;
+    static inline Node moved_tag{};
+    static constexpr Node *MOVED = &moved_tag;
+
+    std::vector<Stripe> stripes;
+    size_t stripe_mask;
+    std::atomic<Table*> current;
+    std::vector<std::unique_ptr<Table>> tables; // every table ever created
+    std::mutex tables_mutex;
+
+    // Fibonacci multiply with the high half folded down, so the low bits
+    // that pick bucket and stripe depend on every bit of the key
+    static size_t hash_of(Key key) {
+        uint64_t h = uint64_t(uint32_t(key)) * 0x9E3779B97F4A7C15ULL;
+        return size_t(h ^ (h >> 32));
+    }
+
+    Stripe &stripe_of(Key key) { return stripes[hash_of(key) & stripe_mask]; }
+
+    // Head of key's chain, following MOVED buckets into successor tables
+    static std::atomic<Node*> &head_of(Table *t, Key key) {
+        for (;;) {
+            std::atomic<Node*> &h = t->heads[hash_of(key) & t->mask];
+            if (h.load(std::memory_order_acquire) != MOVED) return h;
+            t = t->successor.load(std::memory_order_acquire);
+        }
+    }
+
+    // Writer side of the seqlock; the caller holds the stripe exclusively
+    void begin_write(Stripe &st) {
+        st.seq.store(st.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void end_write(Stripe &st) { st.seq.store(st.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    static bool walk(Node *n, Key key, Value &value) {
+        for (; n; n = n->next.load(std::memory_order_acquire))
+            if (n->key.load(std::memory_order_relaxed) == key) {
+                value = n->value.load(std::memory_order_relaxed);
+                return true;
+            }
+        return false;
+    }
+
+    // Links a table twice as large unless a migration is already running
+    void start_grow(Table *t) {
+        if (t->successor.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(tables_mutex);
+        if (t->successor.load(std::memory_order_relaxed) || current.load(std::memory_order_acquire) != t) return;
+        tables.emplace_back(new Table(2 * (t->mask + 1)));
+        t->successor.store(tables.back().get(), std::memory_order_release);
+    }
+
+    // Moves up to MIGRATE_STEP unclaimed buckets of the current table
+    void help_migrate() {
+        Table *t = current.load(std::memory_order_acquire);
+        Table *nt = t->successor.load(std::memory_order_acquire);
+        if (!nt) return;
+        size_t n = t->mask + 1;
+        size_t lo = t->claimed.fetch_add(MIGRATE_STEP, std::memory_order_relaxed);
+        if (lo >= n) return;
+        size_t hi = std::min(n, lo + MIGRATE_STEP);
+        for (size_t i = lo; i < hi; i++) {
+            Stripe &st = stripes[i & stripe_mask];
+            std::unique_lock<std::shared_mutex> lock(st.lock);
+            begin_write(st);
+            Node *node = t->heads[i].load(std::memory_order_relaxed);
+            while (node) {
+                Node *next = node->next.load(std::memory_order_relaxed);
+                std::atomic<Node*> &dst = nt->heads[hash_of(node->key.load(std::memory_order_relaxed)) & nt->mask];
+                node->next.store(dst.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                dst.store(node, std::memory_order_release);
+                node = next;
+            }
+            t->heads[i].store(MOVED, std::memory_order_release);
+            end_write(st);
+        }
+        if (t->moved.fetch_add(hi - lo, std::memory_order_acq_rel) + (hi - lo) == n)
+            current.store(nt, std::memory_order_release);
+    }
+
+public:
+    // buckets is the initial estimate; both counts are rounded up to powers of two
+    StripedHashTable(size_t buckets, size_t n_stripes) {
+        size_t s = 1, b = 1;
+        while (s < n_stripes) s *= 2;
+        while (b < std::max(buckets, s)) b *= 2;
+        stripes = std::vector<Stripe>(s);
+        stripe_mask = s - 1;
+        tables.emplace_back(new Table(b));
+        current.store(tables.back().get());
+    }
+
+    ~StripedHashTable() {
+        auto drop = [](Node *n) { while (n && n != MOVED) { Node *next = n->next.load(std::memory_order_relaxed); delete n; n = next; } };
+        for (auto &t : tables)
+            for (auto &h : t->heads) drop(h.load(std::memory_order_relaxed));
+        for (auto &st : stripes) drop(st.free_list);
+    }
+
+    // Inserts the key, or updates its value if it is already present
+    void insert(Key key, Value value) {
+        help_migrate();
+        Stripe &st = stripe_of(key);
+        Table *t = current.load(std::memory_order_acquire);
+        bool grow;
+        {
+            std::unique_lock<std::shared_mutex> lock(st.lock);
+            std::atomic<Node*> &head = head_of(t, key);
+            for (Node *n = head.load(std::memory_order_relaxed); n; n = n->next.load(std::memory_order_relaxed)) {
+                if (n->key.load(std::memory_order_relaxed) == key) {
+                    n->value.store(value, std::memory_order_relaxed); // one word: no torn read possible
+                    return;
+                }
+            }
+            Node *n = st.free_list;
+            if (n) st.free_list = n->next.load(std::memory_order_relaxed);
+            else n = new Node;
+            begin_write(st);
+            n->key.store(key, std::memory_order_relaxed);
+            n->value.store(value, std::memory_order_relaxed);
+            n->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            head.store(n, std::memory_order_release);
+            end_write(st);
+            // this stripe's keys against its share of the buckets
+            grow = ++st.items > MAX_LOAD * (t->mask + 1) / stripes.size();
+        }
+        if (grow) start_grow(t);
+    }
+
+    bool find(Key key, Value &value) {
+        Stripe &st = stripe_of(key);
+        if (MODE == ReadMode::Optimistic) {
+            for (int attempt = 0; attempt < OPTIMISTIC_TRIES; attempt++) {
+                uint64_t s0 = st.seq.load(std::memory_order_acquire);
+                if (s0 & 1) continue;
+                bool found = false, torn = false;
+                Value v{};
+                Node *n = head_of(current.load(std::memory_order_acquire), key).load(std::memory_order_acquire);
+                for (; n && n != MOVED; n = n->next.load(std::memory_order_acquire)) {
+                    if (st.seq.load(std::memory_order_acquire) != s0) { torn = true; break; }
+                    if (n->key.load(std::memory_order_relaxed) == key) {
+                        v = n->value.load(std::memory_order_relaxed);
+                        found = true;
+                        break;
+                    }
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (!torn && n != MOVED && st.seq.load(std::memory_order_relaxed) == s0) {
+                    if (found) value = v;
+                    return found;
+                }
+            }
+        }
+        std::shared_lock<std::shared_mutex> lock(st.lock);
+        return walk(head_of(current.load(std::memory_order_acquire), key).load(std::memory_order_acquire), key, value);
+    }
+
+    void erase(Key key) {
+        help_migrate();
+        Stripe &st = stripe_of(key);
+        std::unique_lock<std::shared_mutex> lock(st.lock);
+        begin_write(st);
+        std::atomic<Node*> *link = &head_of(current.load(std::memory_order_acquire), key);
+        while (Node *n = link->load(std::memory_order_relaxed)) {
+            if (n->key.load(std::memory_order_relaxed) == key) {
+                link->store(n->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                n->next.store(st.free_list, std::memory_order_relaxed);
+                st.free_list = n;
+                st.items--;
+            } else {
+                link = &n->next;
+            }
+        }
+        end_write(st);
+    }
+
+    size_t bucket_count() { return current.load(std::memory_order_acquire)->mask + 1; }
+};
+
+// 5. Bucketized Cuckoo Hashing
+// Every key has two candidate buckets of 7 slots. A slot packs key and value
+// into one 64-bit word as in OpenHashTable, and the bucket's eighth word holds
+// one tag byte per slot (0 = empty), so a bucket with its tags is exactly one
+// cache line. A lookup compares its 1-byte tag against the primary bucket's
+// tags with one SSE2 compare and reads only the matching slots, all on the
+// same line; it reads the secondary bucket's line only when the primary
+// misses. Inserts fill the primary bucket first, so most hits read one line
+// and a miss reads two.
+// Writers lock the stripes of both candidate buckets (lower stripe first)
+// and bump their seqlock counters; readers take no lock and retry if either
+// counter moved. When both buckets are full, a breadth-first search over at
+// most MAX_BFS_NODES buckets finds the shortest chain of displacements ending
+// in a free slot while holding no lock. The chain is then applied from its
+// free end one move at a time, each move locking only the two buckets it
+// touches and rechecking that the key can still move.
+// Growth: when the search fails, a table twice as large is linked as the
+// successor, and every later insert and erase claims MIGRATE_STEP old
+// buckets and moves their keys over. Each table has its own stripes, and
+// a writer locks the key's old pair before its successor pair. A bucket
+// moves with its stripe locked, which every writer of its keys holds, and
+// each key's successor pair, so no writer or validated reader sees a key
+// in neither table. While migrating, lookups read the old
+// pair and then the successor pair, writers update a key where it is, and
+// new keys go to the successor; the old table only ever empties. The
+// thread that moves the last bucket publishes the successor as current.
+// Retired tables stay allocated until the table is destroyed, since
+// optimistic readers may still be reading them.
+class CuckooHashTable {
+private:
+    static const int SLOTS = 7;
+    static const uint32_t SLOT_MASK = (1u << SLOTS) - 1;
+    static const size_t MAX_BFS_NODES = 2048;
+    static const int MAX_PATH = 5; // displacements per insert
+    static const size_t MIGRATE_STEP = 16;
+    static constexpr double MIGRATE_LOAD = 0.9; // new keys stop short of this successor occupancy
+    static constexpr double START_LOAD = 0.9; // occupancy once `capacity` keys are in
+
+    struct alignas(64) Bucket {
+        std::atomic<uint64_t> tags;         // byte s tags slot s, 0 = empty; byte 7 unused
+        std::atomic<uint64_t> slots[SLOTS]; // key << 32 | value
+    };
+    struct alignas(64) Stripe {
+        std::mutex lock;
+        std::atomic<uint64_t> seq{0}; // odd while a writer holds the stripe
+    };
+    struct Table {
+        size_t n; // any size >= 2; buckets are picked by multiply-shift, not masking
+        std::vector<Bucket> buckets;
+        std::vector<Stripe> stripes; // a power of two
+        std::atomic<Table*> successor{nullptr};
+        std::atomic<size_t> claimed{0}, moved{0};
+        std::atomic<size_t> added{0}; // new keys put in the successor while migrating
+        Table(size_t n, size_t n_stripes) : n(n), buckets(n), stripes(n_stripes) {}
+        Stripe &stripe(size_t b) { return stripes[b & (stripes.size() - 1)]; }
+    };
+    struct Hashed {
+        size_t b1, b2;
+        uint8_t tag;
+    };
+    struct BfsNode {
+        size_t bucket;
+        int parent; // queue index of the bucket whose key moves in here
+        int slot;   // slot of that key in the parent bucket
+        int depth;
+    };
+
+    std::atomic<Table*> current;
+    std::vector<std::unique_ptr<Table>> tables; // every table ever created
+    std::mutex tables_mutex;
+
+    static uint64_t pack(Key k, Value v) { return uint64_t(uint32_t(k)) << 32 | uint32_t(v); }
+    static Key slot_key(uint64_t s) { return Key(uint32_t(s >> 32)); }
+    static Value slot_value(uint64_t s) { return Value(uint32_t(s)); }
+    static uint8_t tag_at(uint64_t tags, int s) { return uint8_t(tags >> (8 * s)); }
+
+    // splitmix64 finalizer: tag from the low byte, buckets from two disjoint
+    // 28-bit fields scaled onto [0, n) by multiply-shift (n < 2^28)
+    static Hashed hash_key(Key key, size_t n) {
+        uint64_t z = uint64_t(uint32_t(key)) + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        Hashed h{size_t(((z >> 8) & 0xFFFFFFF) * n >> 28), size_t((z >> 36) * n >> 28), uint8_t(z)};
+        if (h.b2 == h.b1) h.b2 = h.b1 + 1 == n ? 0 : h.b1 + 1;
+        if (h.tag == 0) h.tag = 1;
+        return h;
+    }
+    static size_t other_bucket(const Hashed &h, size_t b) { return b == h.b1 ? h.b2 : h.b1; }
+
+    // Bit s set when slot s's tag equals tag
+    static uint32_t match_tags(uint64_t tags, uint8_t tag) {
+#ifdef __SSE2__
+        __m128i v = _mm_set_epi64x(0, int64_t(tags));
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(char(tag))))) & SLOT_MASK;
+#else
+        uint32_t m = 0;
+        for (int s = 0; s < SLOTS; s++) m |= uint32_t(tag_at(tags, s) == tag) << s;
+        return m;
+#endif
+    }
+    static uint32_t empty_slots(const Bucket &b) { return match_tags(b.tags.load(std::memory_order_relaxed), 0); }
+
+    // Slot of key in bucket b, or -1
+    static int slot_of(const Bucket &b, uint8_t tag, Key key) {
+        for (uint32_t m = match_tags(b.tags.load(std::memory_order_relaxed), tag); m; m &= m - 1) {
+            int s = __builtin_ctz(m);
+            if (slot_key(b.slots[s].load(std::memory_order_relaxed)) == key) return s;
+        }
+        return -1;
+    }
+
+    // Locks the stripes of two buckets in index order and marks them as being written
+    class PairGuard {
+        Stripe *a, *b;
+    public:
+        PairGuard(Table &t, size_t b1, size_t b2) {
+            a = &t.stripe(b1);
+            b = &t.stripe(b2);
+            if (a > b) std::swap(a, b);
+            a->lock.lock();
+            if (b != a) b->lock.lock();
+            else b = nullptr;
+            begin_write(*a);
+            if (b) begin_write(*b);
+        }
+        ~PairGuard() {
+            if (b) end_write(*b);
+            end_write(*a);
+            if (b) b->lock.unlock();
+            a->lock.unlock();
+        }
+    };
+    static void begin_write(Stripe &st) {
+        st.seq.store(st.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    static void end_write(Stripe &st) { st.seq.store(st.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Bucket holding key, with its slot in s, or nullptr; caller holds both stripes
+    static Bucket *locate(Table *t, const Hashed &h, Key key, int &s) {
+        for (size_t b : {h.b1, h.b2})
+            if ((s = slot_of(t->buckets[b], h.tag, key)) >= 0) return &t->buckets[b];
+        return nullptr;
+    }
+
+    static void put(Bucket &b, int s, uint8_t tag, uint64_t slot) {
+        b.slots[s].store(slot, std::memory_order_relaxed);
+        uint64_t tags = b.tags.load(std::memory_order_relaxed);
+        b.tags.store(tags | uint64_t(tag) << (8 * s), std::memory_order_relaxed);
+    }
+    static void clear(Bucket &b, int s) {
+        uint64_t tags = b.tags.load(std::memory_order_relaxed);
+        b.tags.store(tags & ~(uint64_t(0xFF) << (8 * s)), std::memory_order_relaxed);
+    }
+
+    // Stores key in a free slot of either bucket, primary first
+    static bool place(Table *t, const Hashed &h, Key key, Value value) {
+        for (size_t b : {h.b1, h.b2}) {
+            Bucket &bk = t->buckets[b];
+            if (uint32_t free = empty_slots(bk)) {
+                put(bk, __builtin_ctz(free), h.tag, pack(key, value));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the key in (from, s) to its other bucket `to`; false if it no longer
+    // can, or if t has a successor: a table being migrated only ever empties
+    bool move(Table *t, size_t from, int s, size_t to) {
+        PairGuard guard(*t, from, to);
+        if (t->successor.load(std::memory_order_relaxed)) return false;
+        Bucket &src = t->buckets[from], &dst = t->buckets[to];
+        uint64_t tags = src.tags.load(std::memory_order_relaxed);
+        if (!tag_at(tags, s)) return true; // already vacated
+        uint64_t slot = src.slots[s].load(std::memory_order_relaxed);
+        if (other_bucket(hash_key(slot_key(slot), t->n), from) != to) return false;
+        uint32_t free = empty_slots(dst);
+        if (!free) return false;
+        put(dst, __builtin_ctz(free), tag_at(tags, s), slot); // copy before clearing: never absent
+        clear(src, s);
+        return true;
+    }
+
+    // Frees a slot in h.b1 or h.b2 by a BFS for the shortest displacement
+    // chain; false only when no chain exists within the search limits.
+    // Children are tested for a free slot through their tag word as they are
+    // generated, so only full buckets are ever expanded.
+    bool make_room(Table *t, const Hashed &h) {
+        if (empty_slots(t->buckets[h.b1]) || empty_slots(t->buckets[h.b2]))
+            return true; // freed meanwhile
+        std::vector<BfsNode> queue;
+        queue.reserve(MAX_BFS_NODES);
+        queue.push_back({h.b1, -1, -1, 0});
+        queue.push_back({h.b2, -1, -1, 0});
+        for (size_t qi = 0; qi < queue.size(); qi++) {
+            BfsNode n = queue[qi];
+            if (n.depth == MAX_PATH) continue;
+            for (int s = 0; s < SLOTS; s++) {
+                Key k = slot_key(t->buckets[n.bucket].slots[s].load(std::memory_order_relaxed));
+                BfsNode child{other_bucket(hash_key(k, t->n), n.bucket), int(qi), s, n.depth + 1};
+                if (empty_slots(t->buckets[child.bucket])) {
+                    // apply the chain from the free end back to the root
+                    if (move(t, n.bucket, s, child.bucket))
+                        for (int i = int(qi); queue[i].parent >= 0; i = queue[i].parent)
+                            if (!move(t, queue[queue[i].parent].bucket, queue[i].slot, queue[i].bucket)) break;
+                    return true; // caller retries, whether or not the chain held up
+                }
+                if (queue.size() < MAX_BFS_NODES) queue.push_back(child);
+            }
+        }
+        return false;
+    }
+
+    // A key's buckets locked for writing: its pair in the current table and,
+    // while that table migrates, its pair in the successor, locked second.
+    // Not valid if the tables changed before the locks were taken.
+    struct KeyLock {
+        Table *t, *nt; // nt is null unless t is migrating
+        Hashed h, hn;  // hn == h unless migrating
+        std::optional<PairGuard> old_guard, guard;
+        bool valid;
+        KeyLock(CuckooHashTable &c, Key key) {
+            t = c.current.load(std::memory_order_acquire);
+            nt = t->successor.load(std::memory_order_acquire);
+            h = hn = hash_key(key, t->n);
+            if (nt) {
+                hn = hash_key(key, nt->n);
+                old_guard.emplace(*t, h.b1, h.b2);
+            }
+            guard.emplace(*dst(), hn.b1, hn.b2);
+            valid = c.current.load(std::memory_order_relaxed) == t &&
+                    t->successor.load(std::memory_order_relaxed) == nt &&
+                    !dst()->successor.load(std::memory_order_relaxed);
+        }
+        Table *dst() const { return nt ? nt : t; } // where a new key goes
+        // Bucket holding key, with its slot in s, or nullptr
+        Bucket *locate_key(Key key, int &s) const {
+            if (nt)
+                if (Bucket *b = locate(t, h, key, s)) return b;
+            return locate(dst(), hn, key, s);
+        }
+    };
+
+    // Links a table twice as large unless a migration is already running
+    void start_grow(Table *t) {
+        if (t->successor.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(tables_mutex);
+        if (t->successor.load(std::memory_order_relaxed) || current.load(std::memory_order_acquire) != t) return;
+        tables.emplace_back(new Table(2 * t->n, t->stripes.size()));
+        t->successor.store(tables.back().get(), std::memory_order_release);
+    }
+
+    // Moves every key of old bucket b into nt. Every writer of a key in b
+    // holds b's stripe, so locking it alone keeps the bucket stable and
+    // readers of its keys out; no key enters b once the successor is linked.
+    void migrate_bucket(Table *t, Table *nt, size_t b) {
+        PairGuard old_guard(*t, b, b);
+        Bucket &bk = t->buckets[b];
+        uint64_t tags = bk.tags.load(std::memory_order_relaxed);
+        for (int s = 0; s < SLOTS; s++) {
+            if (!tag_at(tags, s)) continue;
+            uint64_t slot = bk.slots[s].load(std::memory_order_relaxed);
+            Hashed hn = hash_key(slot_key(slot), nt->n);
+            for (;;) {
+                {
+                    PairGuard guard(*nt, hn.b1, hn.b2);
+                    if (place(nt, hn, slot_key(slot), slot_value(slot))) break;
+                }
+                if (!make_room(nt, hn)) throw std::runtime_error("cuckoo table: successor table full");
+            }
+            clear(bk, s);
+        }
+    }
+
+    // Moves up to MIGRATE_STEP unclaimed buckets of the current table
+    void help_migrate() {
+        Table *t = current.load(std::memory_order_acquire);
+        Table *nt = t->successor.load(std::memory_order_acquire);
+        if (!nt) return;
+        size_t lo = t->claimed.fetch_add(MIGRATE_STEP, std::memory_order_relaxed);
+        if (lo >= t->n) return;
+        size_t hi = std::min(t->n, lo + MIGRATE_STEP);
+        for (size_t b = lo; b < hi; b++) migrate_bucket(t, nt, b);
+        if (t->moved.fetch_add(hi - lo, std::memory_order_acq_rel) + (hi - lo) == t->n)
+            current.store(nt, std::memory_order_release);
+    }
+
+public:
+    // Sizes the table so that `capacity` keys fill it to START_LOAD
+    CuckooHashTable(size_t capacity, size_t n_stripes) {
+        size_t s = 1;
+        while (s < n_stripes) s *= 2;
+        size_t b = std::max(size_t(std::ceil(capacity / (SLOTS * START_LOAD))), size_t(2));
+        tables.emplace_back(new Table(b, s));
+        current.store(tables.back().get());
+    }
+
+    // Inserts the key, or updates its value if it is already present
+    void insert(Key key, Value value) {
+        help_migrate();
+        for (;;) {
+            Table *t, *dst;
+            Hashed h;
+            bool full;
+            {
+                KeyLock k(*this, key);
+                if (!k.valid) continue;
+                int s;
+                if (Bucket *b = k.locate_key(key, s)) {
+                    b->slots[s].store(pack(key, value), std::memory_order_relaxed);
+                    return;
+                }
+                t = k.t;
+                dst = k.dst();
+                h = k.hn;
+                // mid-migration, leave the successor room for every key still to move
+                full = dst != t && t->added.load(std::memory_order_relaxed) + SLOTS * t->n >= MIGRATE_LOAD * SLOTS * dst->n;
+                if (!full && place(dst, h, key, value)) {
+                    if (dst != t) t->added.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            if (!full && make_room(dst, h)) continue;
+            if (dst == t) {
+                start_grow(t);
             } else {
-                Value val;
-                table.find(keys[i], val);
+                help_migrate(); // wait for the successor to take over; it grows then
+                std::this_thread::yield();
             }
         }
-        ops_done++;
     }
+
+    bool find(Key key, Value &value) {
+        for (;;) {
+            Table *t = current.load(std::memory_order_acquire);
+            Table *nt = t->successor.load(std::memory_order_acquire);
+            Hashed h = hash_key(key, t->n);
+            Stripe &s1 = t->stripe(h.b1), &s2 = t->stripe(h.b2);
+            uint64_t v1 = s1.seq.load(std::memory_order_acquire), v2 = s2.seq.load(std::memory_order_acquire);
+            if ((v1 | v2) & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            // the secondary bucket's line is only read when the primary misses
+            Bucket *b = &t->buckets[h.b1];
+            int s = slot_of(*b, h.tag, key);
+            if (s < 0) {
+                b = &t->buckets[h.b2];
+                s = slot_of(*b, h.tag, key);
+            }
+            // mid-migration, a key missing from the old pair may be in the successor
+            Stripe *n1 = nullptr, *n2 = nullptr;
+            uint64_t w1 = 0, w2 = 0;
+            if (s < 0 && nt) {
+                Hashed hn = hash_key(key, nt->n);
+                n1 = &nt->stripe(hn.b1);
+                n2 = &nt->stripe(hn.b2);
+                w1 = n1->seq.load(std::memory_order_acquire);
+                w2 = n2->seq.load(std::memory_order_acquire);
+                if ((w1 | w2) & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                b = &nt->buckets[hn.b1];
+                s = slot_of(*b, hn.tag, key);
+                if (s < 0) {
+                    b = &nt->buckets[hn.b2];
+                    s = slot_of(*b, hn.tag, key);
+                }
+            }
+            Value v = s >= 0 ? slot_value(b->slots[s].load(std::memory_order_relaxed)) : Value{};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            bool stable = s1.seq.load(std::memory_order_relaxed) == v1 && s2.seq.load(std::memory_order_relaxed) == v2;
+            if (n1) stable = stable && n1->seq.load(std::memory_order_relaxed) == w1 && n2->seq.load(std::memory_order_relaxed) == w2;
+            if (stable && current.load(std::memory_order_relaxed) == t) {
+                if (s >= 0) value = v;
+                return s >= 0;
+            }
+        }
+    }
+
+    void erase(Key key) {
+        help_migrate();
+        for (;;) {
+            KeyLock k(*this, key);
+            if (!k.valid) continue;
+            int s;
+            if (Bucket *b = k.locate_key(key, s)) clear(*b, s);
+            return;
+        }
+    }
+
+    // Share of occupied slots; not safe against concurrent writers
+    double load_factor() {
+        Table *t = current.load(std::memory_order_acquire);
+        size_t used = 0;
+        for (auto &b : t->buckets) used += SLOTS - __builtin_popcount(empty_slots(b));
+        return double(used) / (SLOTS * t->n);
+    }
+};
+
+// ===================== Benchmark Utilities =====================
+// Every run gets a fresh table, prefilled with key indices 0..n_keys-1, and
+// draws its keys from a universe of 2 * n_keys indices, so about half the
+// lookups hit and half the inserts add a new key. Each thread counts its own ops and
+// samples its own latencies; nothing but the phase flag is shared.
+struct WorkloadMix {
+    std::string name;
+    int read_pct, insert_pct, erase_pct; // per 100 ops
+};
+
+enum class KeyDist { Uniform, Zipfian, Hotspot };
+const std::vector<std::string> DIST_NAMES = {"Uniform", "Zipfian", "Hotspot"};
+
+// Draws key ranks (0 = hottest) and maps them to keys in two steps: a
+// multiply by a prime modulo the universe turns the rank into an index, so
+// hotness is unrelated to whether the key was prefilled, and a bijective
+// 32-bit mix turns the index into a key, so keys are spread over the whole
+// int range rather than a dense block the identity-hashed tables favor.
+class KeyGenerator {
+private:
+    KeyDist dist;
+    uint64_t universe;
+    std::mt19937_64 gen;
+    double zipf_zetan, zipf_eta, zipf_alpha; // YCSB Zipfian (Gray et al.)
+
+public:
+    static constexpr double ZIPF_THETA = 0.99;
+    static constexpr double HOT_KEYS = 0.1;  // Hotspot: this share of the keys
+    static constexpr double HOT_OPS = 0.9;   // gets this share of the ops
+    static const uint64_t SCRAMBLE = 2654435761u; // prime, coprime to the universe
+
+    // zetan = sum_{i=1..universe} 1/i^theta, shared by every thread's generator
+    static double zeta(uint64_t n) {
+        double z = 0;
+        for (uint64_t i = 1; i <= n; i++) z += 1.0 / std::pow(double(i), ZIPF_THETA);
+        return z;
+    }
+
+    KeyGenerator(KeyDist d, uint64_t u, double zetan, uint64_t seed)
+        : dist(d), universe(u), gen(seed), zipf_zetan(zetan) {
+        double zeta2 = 1.0 + 1.0 / std::pow(2.0, ZIPF_THETA);
+        zipf_alpha = 1.0 / (1.0 - ZIPF_THETA);
+        zipf_eta = (1.0 - std::pow(2.0 / universe, 1.0 - ZIPF_THETA)) / (1.0 - zeta2 / zipf_zetan);
+    }
+
+    double uniform01() { return (gen() >> 11) * 0x1.0p-53; }
+    uint64_t below(uint64_t n) { return (unsigned __int128)gen() * n >> 64; }
+
+    uint64_t next_rank() {
+        switch (dist) {
+        case KeyDist::Uniform:
+            return below(universe);
+        case KeyDist::Zipfian: {
+            double u = uniform01(), uz = u * zipf_zetan;
+            if (uz < 1.0) return 0;
+            if (uz < 1.0 + std::pow(0.5, ZIPF_THETA)) return 1;
+            uint64_t r = uint64_t(universe * std::pow(zipf_eta * (u - 1.0) + 1.0, zipf_alpha));
+            return std::min(r, universe - 1);
+        }
+        default: {
+            uint64_t hot = std::max<uint64_t>(1, uint64_t(universe * HOT_KEYS));
+            return uniform01() < HOT_OPS ? below(hot) : hot + below(universe - hot);
+        }
+        }
+    }
+
+    // murmur3's fmix32 is a bijection on 32 bits; index + 1 keeps key 0
+    // free, so the reserved INT_MIN can be remapped onto it
+    static Key key_at(uint64_t index) {
+        uint32_t h = uint32_t(index + 1);
+        h ^= h >> 16; h *= 0x85EBCA6Bu;
+        h ^= h >> 13; h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        Key k = Key(h);
+        return k == std::numeric_limits<Key>::min() ? 0 : k;
+    }
+
+    Key next_key() { return key_at(next_rank() * SCRAMBLE % universe); }
+};
+
+// Log-linear latency histogram: 8 sub-buckets per power of two of ns,
+// so any reported percentile is within 1/8 of the true value
+struct LatencyHistogram {
+    static const int SUB_BITS = 3;
+    static const int N_BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+    uint64_t counts[N_BUCKETS] = {};
+
+    static int bucket_of(uint64_t ns) {
+        if (ns < (1u << SUB_BITS)) return int(ns);
+        int e = 63 - __builtin_clzll(ns);
+        return ((e - SUB_BITS + 1) << SUB_BITS) + int((ns >> (e - SUB_BITS)) & ((1u << SUB_BITS) - 1));
+    }
+    static double midpoint_of(int b) {
+        if (b < (1 << SUB_BITS)) return b;
+        int e = (b >> SUB_BITS) + SUB_BITS - 1;
+        uint64_t lo = uint64_t((1 << SUB_BITS) + (b & ((1 << SUB_BITS) - 1))) << (e - SUB_BITS);
+        return lo + double(1ull << (e - SUB_BITS)) / 2;
+    }
+
+    void record(uint64_t ns) { counts[bucket_of(ns)]++; }
+    void merge(const LatencyHistogram &o) { for (int b = 0; b < N_BUCKETS; b++) counts[b] += o.counts[b]; }
+
+    double percentile(double p) const {
+        uint64_t total = 0;
+        for (uint64_t c : counts) total += c;
+        if (!total) return 0;
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(p * total))), seen = 0;
+        for (int b = 0; b < N_BUCKETS; b++)
+            if ((seen += counts[b]) >= rank) return midpoint_of(b);
+        return midpoint_of(N_BUCKETS - 1);
+    }
+};
+
+// Padded so one thread's counter updates never invalidate another's line
+struct alignas(64) WorkerStats {
+    uint64_t ops = 0;
+    uint64_t checksum = 0; // lookup results, so no find() can be optimized away
+    LatencyHistogram latency;
+};
+
+volatile uint64_t sink; // receives every run's checksum
+
+struct RunResult {
+    double tput, p50_ns, p99_ns, p999_ns;
+};
+
+struct RunConfig {
+    double warmup_s = 0.1;
+    double duration_s = 0.5;
+    size_t sample_every = 8; // latency is sampled on one op in this many
+};
+
+enum Phase { WAITING, WARMUP, MEASURE, STOP };
+
+// CPUs in this process's affinity mask
+const std::vector<int> &allowed_cpus() {
+    static const std::vector<int> cpus = [] {
+        std::vector<int> v;
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &set)) v.push_back(c);
+        return v;
+    }();
+    return cpus;
+}
+
+// Pins worker t to the t-th allowed CPU (wrapping); warns once if that fails
+void pin_to_cpu(size_t t) {
+    static std::atomic<bool> warned(false);
+    const std::vector<int> &cpus = allowed_cpus();
+    int rc = ENOENT;
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[t % cpus.size()], &set);
+        rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    if (rc != 0 && !warned.exchange(true))
+        std::cerr << "⚠️ could not pin threads (" << std::strerror(rc) << "); running unpinned\n";
+}
+
+// Cost of one back-to-back pair of clock reads, subtracted from each sample
+uint64_t timer_overhead_ns() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 10000; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min<uint64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    return best;
+}
+
+// Returns what a lookup saw, for the worker's checksum
+template<typename Table>
+inline uint64_t run_op(Table &table, const WorkloadMix &mix, int roll, Key key) {
+    if (roll < mix.read_pct) {
+        Value val = 0;
+        bool hit = table.find(key, val);
+        return hit + uint64_t(uint32_t(val));
+    } else if (roll < mix.read_pct + mix.insert_pct) {
+        table.insert(key, key);
+    } else {
+        table.erase(key);
+    }
+    return 0;
 }
 
 template<typename Table>
-double benchmark(Table &table, WorkloadType workload,
-                 const std::vector<Key> &keys, size_t n_threads) {
+RunResult benchmark(Table &table, const WorkloadMix &mix, KeyDist dist,
+                    size_t n_keys, double zetan, size_t n_threads,
+                    const RunConfig &cfg, uint64_t timer_ns) {
+    std::vector<WorkerStats> stats(n_threads);
+    std::atomic<int> phase(WAITING);
+    std::atomic<size_t> ready(0);
     std::vector<std::thread> threads;
-    std::atomic<size_t> ops_done(0);
 
-    size_t chunk = keys.size() / n_threads;
-    auto start_time = std::chrono::high_resolution_clock::now();
     for (size_t t = 0; t < n_threads; t++) {
-        size_t start = t * chunk;
-        size_t end = (t == n_threads - 1) ? keys.size() : start + chunk;
-        threads.emplace_back(run_workload<Table>,
-                             std::ref(table),
-                             workload,
-                             std::cref(keys),
-                             start, end,
-                             std::ref(ops_done));
+        threads.emplace_back([&, t] {
+            pin_to_cpu(t);
+            KeyGenerator keys(dist, 2 * n_keys, zetan, 0x9E3779B97F4A7C15ull * (t + 1));
+            WorkerStats &st = stats[t];
+            ready++;
+            while (phase.load(std::memory_order_acquire) == WAITING) std::this_thread::yield();
+
+            for (uint64_t i = 0;; i++) {
+                int ph = phase.load(std::memory_order_relaxed);
+                if (ph == STOP) break;
+                bool measuring = ph == MEASURE; // warmup ops are neither counted nor sampled
+                int roll = int(keys.below(100));
+                Key key = keys.next_key();
+                if (measuring && i % cfg.sample_every == 0) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    st.checksum += run_op(table, mix, roll, key);
+                    auto t1 = std::chrono::steady_clock::now();
+                    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+                    st.latency.record(ns > timer_ns ? ns - timer_ns : 0);
+                } else {
+                    st.checksum += run_op(table, mix, roll, key);
+                }
+                st.ops += measuring;
+            }
+        });
     }
+
+    while (ready.load() < n_threads) std::this_thread::yield();
+    phase.store(WARMUP, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.warmup_s));
+    auto start_time = std::chrono::steady_clock::now();
+    phase.store(MEASURE, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.duration_s));
+    phase.store(STOP, std::memory_order_release);
+    auto end_time = std::chrono::steady_clock::now();
     for (auto &th : threads) th.join();
-    auto end_time = std::chrono::high_resolution_clock::now();
 
+    uint64_t ops = 0, checksum = 0;
+    LatencyHistogram latency;
+    for (auto &st : stats) {
+        ops += st.ops;
+        checksum += st.checksum;
+        latency.merge(st.latency);
+    }
+    sink = sink + checksum;
     double elapsed_s = std::chrono::duration<double>(end_time - start_time).count();
-    return ops_done / elapsed_s; // throughput
+    return {ops / elapsed_s, latency.percentile(0.50), latency.percentile(0.99), latency.percentile(0.999)};
+}
+
+// Builds a fresh table, fills it with the keys at indices 0..n_keys-1 and runs one configuration
+template<typename Make>
+RunResult run_table(Make make, const WorkloadMix &mix, KeyDist dist, size_t n_keys,
+                    double zetan, size_t n_threads, const RunConfig &cfg, uint64_t timer_ns) {
+    auto table = make();
+    for (size_t i = 0; i < n_keys; i++) {
+        Key k = KeyGenerator::key_at(i);
+        table->insert(k, k);
+    }
+    return benchmark(*table, mix, dist, n_keys, zetan, n_threads, cfg, timer_ns);
 }
 
 // ===================== CSV Output Helper =====================
-void write_csv(const std::string &filename, bool append,
-               size_t dataset_size, size_t threads,
-               const std::string &workload,
-               double coarse_tput, double fine_tput) {
-    std::ofstream file;
-    if (append) file.open(filename, std::ios::app);
-    else {
-        file.open(filename);
-        file << "Dataset,Threads,Workload,CoarseTput,FineTput\n";
-    }
-    file << dataset_size << "," << threads << "," << workload
-         << "," << coarse_tput << "," << fine_tput << "\n";
-    file.close();
+void write_csv(std::ofstream &file, size_t dataset_size, const std::string &dist,
+               const std::string &workload, size_t threads,
+               const std::string &table, const RunResult &r) {
+    file << dataset_size << "," << dist << "," << workload << "," << threads << ","
+         << table << "," << r.tput << "," << r.p50_ns << "," << r.p99_ns << "," << r.p999_ns << "\n";
 }
 
 // ===================== Main Benchmark =====================
-int main() {
-    std::vector<size_t> dataset_sizes = {10000, 100000, 1000000};
-    std::vector<size_t> thread_counts = {1, 2, 4, 8, 16};
-    std::vector<WorkloadType> workloads = {WorkloadType::LookupOnly,
-                                           WorkloadType::InsertOnly,
-                                           WorkloadType::Mixed7030};
+const size_t STRIPES = 256; // lock stripes of the striped tables
 
-    for (auto n_keys : dataset_sizes) {
-        std::vector<Key> keys(n_keys);
-        std::iota(keys.begin(), keys.end(), 1);
+void usage(const char *prog) {
+    std::cerr << "usage: " << prog << " [--duration S] [--warmup S] [--mix NAME:R/I/E]...\n"
+              << "  --mix sets read/insert/erase percentages (non-negative, summing to 100);\n"
+              << "  each --mix replaces the default workloads\n";
+}
 
-        size_t n_buckets = std::max(n_keys / 10, size_t(16));
-        CoarseHashTable coarse(n_buckets);
-        FineHashTable fine(n_buckets);
+double parse_seconds(const std::string &opt, const std::string &val, bool allow_zero) {
+    char *end = nullptr;
+    double s = std::strtod(val.c_str(), &end);
+    if (val.empty() || *end != '\0' || !std::isfinite(s) || s < 0 || (s == 0 && !allow_zero))
+        throw std::runtime_error(opt + " expects a " + (allow_zero ? "non-negative" : "positive") +
+                                 " number of seconds, got " + val);
+    return s;
+}
+
+WorkloadMix parse_mix(const std::string &val) {
+    WorkloadMix m;
+    size_t colon = val.find(':');
+    char rest;
+    if (colon == std::string::npos || colon == 0 ||
+        std::sscanf(val.c_str() + colon + 1, "%d/%d/%d%c", &m.read_pct, &m.insert_pct, &m.erase_pct, &rest) != 3 ||
+        m.read_pct < 0 || m.insert_pct < 0 || m.erase_pct < 0 ||
+        m.read_pct + m.insert_pct + m.erase_pct != 100)
+        throw std::runtime_error("--mix expects NAME:R/I/E, non-negative and summing to 100, got " + val);
+    m.name = val.substr(0, colon);
+    return m;
+}
 
-        for (auto workload : workloads) {
-            std::string workload_str = (workload==WorkloadType::LookupOnly?"LookupOnly":
-                                        workload==WorkloadType::InsertOnly?"InsertOnly":"Mixed70/30");
-            std::string csv_filename = "benchmark_" + workload_str + "_" + std::to_string(n_keys) + ".csv";
-            bool first_write = true;
+int main(int argc, char **argv) {
+    RunConfig cfg;
+    std::vector<WorkloadMix> mixes;
+    try {
+        for (int a = 1; a < argc; a++) {
+            std::string arg = argv[a];
+            if (arg == "--help" || arg == "-h") {
+                usage(argv[0]);
+                return 0;
+            }
+            if (arg != "--duration" && arg != "--warmup" && arg != "--mix")
+                throw std::runtime_error("unknown option " + arg);
+            if (a + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+            std::string val = argv[++a];
+            if (arg == "--duration") cfg.duration_s = parse_seconds(arg, val, false);
+            else if (arg == "--warmup") cfg.warmup_s = parse_seconds(arg, val, true);
+            else mixes.push_back(parse_mix(val));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        usage(argv[0]);
+        return 1;
+    }
+    if (mixes.empty())
+        mixes = {{"LookupOnly", 100, 0, 0}, {"InsertOnly", 0, 100, 0},
+                 {"Mixed70/30", 70, 30, 0}, {"Churn90/5/5", 90, 5, 5}};
+
+    std::vector<size_t> dataset_sizes = {10000, 100000, 1000000};
+    std::vector<size_t> thread_counts = {1, 2, 4, 8, 16};
+    std::vector<KeyDist> dists = {KeyDist::Uniform, KeyDist::Zipfian, KeyDist::Hotspot};
+    uint64_t timer_ns = timer_overhead_ns();
 
-            for (auto n_threads : thread_counts) {
-                double coarse_tput = benchmark(coarse, workload, keys, n_threads);
-                double fine_tput   = benchmark(fine,   workload, keys, n_threads);
+    std::filesystem::create_directory("results");
+    std::ofstream file("results/hash_benchmark.csv");
+    file << "Dataset,Distribution,Workload,Threads,Table,Tput,P50_ns,P99_ns,P999_ns\n";
 
-                std::cout << "Dataset: " << n_keys
-                          << " | Threads: " << n_threads
-                          << " | Workload: " << workload_str
-                          << " | Coarse Tput: " << coarse_tput
-                          << " | Fine Tput: "   << fine_tput
-                          << std::endl;
+    for (auto n_keys : dataset_sizes) {
+        size_t n_buckets = std::max(n_keys / 10, size_t(16));
+        double zetan = KeyGenerator::zeta(2 * n_keys);
+        for (auto dist : dists) {
+            for (auto &mix : mixes) {
+                for (auto n_threads : thread_counts) {
+                    auto run = [&](auto make) {
+                        return run_table(make, mix, dist, n_keys, zetan, n_threads, cfg, timer_ns);
+                    };
+                    std::vector<std::pair<std::string, RunResult>> results = {
+                        {"Coarse", run([&]{ return std::make_unique<CoarseHashTable>(n_buckets); })},
+                        {"Fine", run([&]{ return std::make_unique<FineHashTable>(n_buckets); })},
+                        {"Open", run([&]{ return std::make_unique<OpenHashTable>(n_buckets); })},
+                        {"StripedRW", run([&]{ return std::make_unique<StripedHashTable<ReadMode::Shared>>(n_buckets, STRIPES); })},
+                        {"StripedSeq", run([&]{ return std::make_unique<StripedHashTable<ReadMode::Optimistic>>(n_buckets, STRIPES); })},
+                        {"Cuckoo", run([&]{ return std::make_unique<CuckooHashTable>(n_keys, STRIPES); })},
+                    };
 
-                write_csv(csv_filename, !first_write, n_keys, n_threads, workload_str,
-                          coarse_tput, fine_tput);
-                first_write = false;
+                    std::cout << "Dataset: " << n_keys
+                              << " | Dist: " << DIST_NAMES[int(dist)]
+                              << " | Workload: " << mix.name
+                              << " | Threads: " << n_threads;
+                    for (auto &[name, r] : results) {
+                        std::cout << " | " << name << " Tput: " << r.tput << " p99: " << r.p99_ns << " ns";
+                        write_csv(file, n_keys, DIST_NAMES[int(dist)], mix.name, n_threads, name, r);
+                    }
+                    std::cout << std::endl;
+                }
             }
         }
     }
+    std::cout << "✅ Results saved to results/hash_benchmark.csv\n";
 }
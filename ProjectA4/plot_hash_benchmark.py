@@ -1,79 +1,78 @@
 # plot_hash_benchmark.py
 import os
-import glob
 import pandas as pd
 import matplotlib.pyplot as plt
 
-RESULTS_DIR = "results"
+RESULTS_FILE = os.path.join("results", "hash_benchmark.csv")
 OUTPUT_DIR = "plots"
 
 os.makedirs(OUTPUT_DIR, exist_ok=True)
 
-# Find all CSV files
-csv_files = glob.glob(os.path.join(RESULTS_DIR, "*.csv"))
-
-# Combine all CSVs into a single DataFrame
-all_data = []
-for csv_file in csv_files:
-    df = pd.read_csv(csv_file)
-    all_data.append(df)
-data = pd.concat(all_data, ignore_index=True)
-
-# Convert Threads column to int just in case
+# One row per (Dataset, Distribution, Workload, Threads, Table)
+data = pd.read_csv(RESULTS_FILE)
 data['Threads'] = data['Threads'].astype(int)
 
-# Unique workloads and dataset sizes
-workloads = data['Workload'].unique()
-datasets = sorted(data['Dataset'].unique())
-
-# Plot throughput vs threads for each workload & dataset
-for workload in workloads:
-    for dataset in datasets:
-        subset = data[(data['Workload'] == workload) & (data['Dataset'] == dataset)]
-        if subset.empty:
-            continue
-
-        plt.figure(figsize=(8,6))
-        plt.plot(subset['Threads'], subset['CoarseTput'], marker='o', label='Coarse-Grained')
-        plt.plot(subset['Threads'], subset['FineTput'], marker='s', label='Fine-Grained')
-        plt.xlabel("Number of Threads")
-        plt.ylabel("Throughput (ops/s)")
-        plt.title(f"{workload} - Dataset {dataset} keys")
-        plt.xscale("log", base=2)
-        plt.xticks(subset['Threads'], subset['Threads'])
-        plt.legend()
-        plt.grid(True, which="both", ls="--", alpha=0.5)
-        plt.tight_layout()
+LABELS = {
+    "Coarse": "Coarse-Grained",
+    "Fine": "Fine-Grained",
+    "Open": "Open Addressing (lock-free)",
+    "StripedRW": "Striped (shared_mutex reads)",
+    "StripedSeq": "Striped (seqlock reads)",
+    "Cuckoo": "Bucketized Cuckoo",
+}
+MARKERS = "os^vDPX*"
+tables = list(dict.fromkeys(data['Table']))
 
-        # Save figure
-        filename = f"{workload}_{dataset}_throughput.png"
-        plt.savefig(os.path.join(OUTPUT_DIR, filename), dpi=200)
-        plt.close()
-        print(f"✅ Saved plot: {filename}")
+# Workload names may contain '/', e.g. Mixed70/30
+def plot_name(*parts):
+    return "_".join(str(p).replace("/", "-") for p in parts) + ".png"
 
-# Optional: Plot speedup vs threads
-for workload in workloads:
-    for dataset in datasets:
-        subset = data[(data['Workload'] == workload) & (data['Dataset'] == dataset)]
-        if subset.empty:
+def plot_metric(subset, metric, ylabel, title, filename, relative=False, logy=False):
+    plt.figure(figsize=(8,6))
+    for i, table in enumerate(tables):
+        rows = subset[subset['Table'] == table].sort_values('Threads')
+        if rows.empty:
             continue
+        y = rows[metric] / rows[metric].iloc[0] if relative else rows[metric]
+        plt.plot(rows['Threads'], y, marker=MARKERS[i % len(MARKERS)], label=LABELS.get(table, table))
+    threads = sorted(subset['Threads'].unique())
+    plt.xlabel("Number of Threads")
+    plt.ylabel(ylabel)
+    plt.title(title)
+    plt.xscale("log", base=2)
+    if logy:
+        plt.yscale("log")
+    plt.xticks(threads, threads)
+    plt.legend()
+    plt.grid(True, which="both", ls="--", alpha=0.5)
+    plt.tight_layout()
+    plt.savefig(os.path.join(OUTPUT_DIR, filename), dpi=200)
+    plt.close()
+    print(f"✅ Saved plot: {filename}")
 
-        plt.figure(figsize=(8,6))
-        baseline_coarse = subset['CoarseTput'].iloc[0]
-        baseline_fine   = subset['FineTput'].iloc[0]
-        plt.plot(subset['Threads'], subset['CoarseTput']/baseline_coarse, marker='o', label='Coarse-Grained')
-        plt.plot(subset['Threads'], subset['FineTput']/baseline_fine, marker='s', label='Fine-Grained')
-        plt.xlabel("Number of Threads")
-        plt.ylabel("Speedup vs 1 Thread")
-        plt.title(f"{workload} - Dataset {dataset} keys (Speedup)")
-        plt.xscale("log", base=2)
-        plt.xticks(subset['Threads'], subset['Threads'])
-        plt.legend()
-        plt.grid(True, which="both", ls="--", alpha=0.5)
-        plt.tight_layout()
+# Throughput, speedup and tail latency vs threads for each configuration
+for (dataset, dist, workload), subset in data.groupby(['Dataset', 'Distribution', 'Workload']):
+    title = f"{workload} - {dist} keys - Dataset {dataset} keys"
+    plot_metric(subset, 'Tput', "Throughput (ops/s)", title,
+                plot_name(workload, dist, dataset, "throughput"))
+    plot_metric(subset, 'Tput', "Speedup vs 1 Thread", f"{title} (Speedup)",
+                plot_name(workload, dist, dataset, "speedup"), relative=True)
+    plot_metric(subset, 'P99_ns', "p99 latency (ns)", f"{title} (p99)",
+                plot_name(workload, dist, dataset, "p99"), logy=True)
 
-        # Save figure
-        filename = f"{workload}_{dataset}_speedup.png"
-        plt.savefig(os.path.join(OUTPUT_DIR, filename), dpi=200)
-        plt.close()
-        print(f"✅ Saved plot: {filename}")
+# Latency percentiles per table at the largest thread count
+max_threads = data['Threads'].max()
+for (dataset, dist, workload), subset in data[data['Threads'] == max_threads].groupby(['Dataset', 'Distribution', 'Workload']):
+    subset = subset.set_index('Table').reindex(tables)
+    ax = subset[['P50_ns', 'P99_ns', 'P999_ns']].plot.bar(figsize=(8,6), logy=True, rot=20)
+    ax.set_xticklabels([LABELS.get(t, t) for t in subset.index])
+    ax.set_xlabel("")
+    ax.set_ylabel("Latency (ns)")
+    ax.set_title(f"{workload} - {dist} keys - Dataset {dataset} keys ({max_threads} threads)")
+    ax.legend(["p50", "p99", "p99.9"])
+    ax.grid(True, axis="y", which="both", ls="--", alpha=0.5)
+    plt.tight_layout()
+    filename = plot_name(workload, dist, dataset, "latency")
+    plt.savefig(os.path.join(OUTPUT_DIR, filename), dpi=200)
+    plt.close()
+    print(f"✅ Saved plot: {filename}")
@@ -0,0 +1,48 @@
+# plot_work_stealing.py
+import os
+import pandas as pd
+import matplotlib.pyplot as plt
+
+RESULTS_FILE = os.path.join("results", "work_stealing.csv")
+OUTPUT_DIR = "plots"
+
+os.makedirs(OUTPUT_DIR, exist_ok=True)
+
+data = pd.read_csv(RESULTS_FILE)
+data['Threads'] = data['Threads'].astype(int)
+
+markers = {'Static': 'o', 'CentralQueue': 's', 'WorkStealing': '^'}
+
+# Makespan and speedup vs threads for each task graph, with and without noise
+for graph in data['Graph'].unique():
+    for noise in sorted(data['Noise'].unique()):
+        subset = data[(data['Graph'] == graph) & (data['Noise'] == noise)]
+        if subset.empty:
+            continue
+        suffix = "noise" if noise else "quiet"
+
+        for metric in ['makespan', 'speedup']:
+            plt.figure(figsize=(8,6))
+            for sched, group in subset.groupby('Scheduler'):
+                group = group.sort_values('Threads')
+                y = group['Makespan_s']
+                if metric == 'speedup':
+                    y = y.iloc[0] / y
+                plt.plot(group['Threads'], y, marker=markers.get(sched, 'o'), label=sched)
+            plt.xlabel("Number of Threads")
+            plt.ylabel("Makespan (s)" if metric == 'makespan' else "Speedup vs 1 Thread")
+            plt.title(f"{graph} Tasks - {'With' if noise else 'No'} Background Thread")
+            plt.xscale("log", base=2)
+            plt.xticks(subset['Threads'].unique(), subset['Threads'].unique())
+            plt.legend()
+            plt.grid(True, which="both", ls="--", alpha=0.5)
+            plt.tight_layout()
+
+            filename = f"work_stealing_{graph}_{suffix}_{metric}.png"
+            plt.savefig(os.path.join(OUTPUT_DIR, filename), dpi=200)
+            plt.close()
+            print(f"✅ Saved plot: {filename}")
+
+# Steal counts per run for the work-stealing scheduler
+ws = data[data['Scheduler'] == 'WorkStealing']
+print(ws[['Graph', 'Threads', 'Noise', 'Steals', 'StealAttempts']].to_string(index=False))
@@ -0,0 +1,375 @@
+// work_stealing_benchmark.cpp
+// ECSE 4320 Project A4 — Work-Stealing Scheduler vs Static Partitioning
+// Compares static chunking, a central locked queue and Chase-Lev work stealing
+// on uniform, skewed and recursive task graphs, with an optional noisy neighbor.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <pthread.h>
+#include <sched.h>
+
+// ===================== Tasks =====================
+// A task is packed into 64 bits so deque slots can be plain atomics:
+// low 32 bits = cost (spin units), high 32 bits = recursion depth.
+using Task = uint64_t;
+
+inline Task make_task(uint32_t cost, uint32_t depth) { return (uint64_t(depth) << 32) | cost; }
+inline uint32_t task_cost(Task t) { return uint32_t(t); }
+inline uint32_t task_depth(Task t) { return uint32_t(t >> 32); }
+
+enum class Graph { Uniform, Skewed, Recursive };
+
+// CPU-bound body; the return value keeps the loop alive
+inline uint64_t spin(uint32_t cost) {
+    uint64_t x = cost;
+    for (uint32_t i = 0; i < cost; i++) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x;
+}
+
+// Runs one task and returns its children (Fibonacci tree: depth d spawns d-1 and d-2)
+template<typename Push>
+inline uint64_t execute(Task t, Graph g, Push &&push) {
+    uint64_t r = spin(task_cost(t));
+    uint32_t d = task_depth(t);
+    if (g == Graph::Recursive && d >= 2) {
+        push(make_task(task_cost(t), d - 1));
+        push(make_task(task_cost(t), d - 2));
+    }
+    return r;
+}
+
+struct Workload {
+    Graph graph;
+    std::vector<Task> roots;
+    size_t total_tasks;
+};
+
+constexpr uint32_t BASE_COST = 2000;
+constexpr size_t FLAT_TASKS = 200000;
+constexpr uint32_t FIB_DEPTH = 25;
+
+size_t fib_tree_size(uint32_t d) { return d < 2 ? 1 : 1 + fib_tree_size(d - 1) + fib_tree_size(d - 2); }
+
+Workload make_workload(Graph g) {
+    Workload w{g, {}, 0};
+    std::mt19937_64 rng(42);
+    if (g == Graph::Uniform) {
+        w.roots.assign(FLAT_TASKS, make_task(BASE_COST, 0));
+    } else if (g == Graph::Skewed) {
+        // Pareto(alpha = 1.2) costs, capped at 1000x the base: a few huge tasks
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        for (size_t i = 0; i < FLAT_TASKS; i++) {
+            double c = BASE_COST / 6.0 / std::pow(1.0 - u(rng), 1.0 / 1.2);
+            w.roots.push_back(make_task(uint32_t(std::min(c, 1000.0 * BASE_COST)), 0));
+        }
+    } else {
+        w.roots.push_back(make_task(BASE_COST / 2, FIB_DEPTH));
+    }
+    w.total_tasks = g == Graph::Recursive ? fib_tree_size(FIB_DEPTH) : w.roots.size();
+    return w;
+}
+
+// ===================== Chase-Lev Deque =====================
+// Owner pushes/takes at the bottom, thieves steal from the top
+// (Lê, Pop, Cohen, Zappa Nardelli, PPoPP'13 C11 formulation). Fixed capacity.
+class ChaseLevDeque {
+    std::unique_ptr<std::atomic<Task>[]> buf;
+    int64_t mask;
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+
+public:
+    static constexpr Task EMPTY = ~0ULL;
+
+    explicit ChaseLevDeque(size_t capacity) : buf(new std::atomic<Task>[capacity]), mask(capacity - 1) {}
+
+    void push(Task x) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > mask) { std::cerr << "deque overflow\n"; std::abort(); }
+        buf[b & mask].store(x, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    Task take() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        Task x = EMPTY;
+        if (t <= b) {
+            x = buf[b & mask].load(std::memory_order_relaxed);
+            if (t == b) { // last element: race against thieves
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    x = EMPTY;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    Task steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return EMPTY;
+        Task x = buf[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return EMPTY; // lost the race; caller retries elsewhere
+        return x;
+    }
+};
+
+// ===================== Benchmark Utilities =====================
+struct alignas(64) WorkerStats {
+    uint64_t tasks = 0, steals = 0, steal_attempts = 0, checksum = 0;
+};
+
+struct RunResult {
+    double makespan_s;
+    uint64_t tasks, steals, steal_attempts;
+};
+
+// CPUs in this process's affinity mask
+const std::vector<int> &allowed_cpus() {
+    static const std::vector<int> cpus = [] {
+        std::vector<int> v;
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &set)) v.push_back(c);
+        return v;
+    }();
+    return cpus;
+}
+
+// Pins worker t to the t-th allowed CPU (wrapping); warns once if that fails
+void pin_to_cpu(size_t t) {
+    static std::atomic<bool> warned(false);
+    const std::vector<int> &cpus = allowed_cpus();
+    int rc = ENOENT;
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[t % cpus.size()], &set);
+        rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    if (rc != 0 && !warned.exchange(true))
+        std::cerr << "⚠️ could not pin threads (" << std::strerror(rc) << "); running unpinned\n";
+}
+
+// Runs fn(tid) on n_threads pinned workers; returns wall time
+template<typename Fn>
+double run_workers(size_t n_threads, Fn &&fn) {
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (size_t t = 0; t < n_threads; t++)
+        threads.emplace_back([&, t] { pin_to_cpu(t); fn(t); });
+    for (auto &th : threads) th.join();
+    auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+RunResult collect(double elapsed, const std::vector<WorkerStats> &stats) {
+    RunResult r{elapsed, 0, 0, 0};
+    for (auto &s : stats) { r.tasks += s.tasks; r.steals += s.steals; r.steal_attempts += s.steal_attempts; }
+    return r;
+}
+
+// ===================== Schedulers =====================
+
+// 1. Static partitioning: contiguous chunk per thread; recursive graphs are
+//    expanded breadth-first until there are enough subtrees to hand out
+RunResult run_static(const Workload &w, size_t n_threads) {
+    std::vector<Task> roots = w.roots;
+    uint64_t expanded_nodes = 0, pre_checksum = 0;
+    if (w.graph == Graph::Recursive) {
+        while (roots.size() < n_threads * 4) {
+            std::vector<Task> next;
+            bool expanded = false;
+            for (Task t : roots) {
+                if (task_depth(t) >= 2) {
+                    pre_checksum += spin(task_cost(t));
+                    expanded_nodes++;
+                    next.push_back(make_task(task_cost(t), task_depth(t) - 1));
+                    next.push_back(make_task(task_cost(t), task_depth(t) - 2));
+                    expanded = true;
+                } else next.push_back(t);
+            }
+            if (!expanded) break;
+            roots.swap(next);
+        }
+    }
+    std::vector<WorkerStats> stats(n_threads);
+    size_t chunk = roots.size() / n_threads;
+    double elapsed = run_workers(n_threads, [&](size_t t) {
+        size_t start = t * chunk;
+        size_t end = (t == n_threads - 1) ? roots.size() : start + chunk;
+        std::vector<Task> stack;
+        for (size_t i = start; i < end; i++) {
+            stack.push_back(roots[i]);
+            while (!stack.empty()) {
+                Task x = stack.back(); stack.pop_back();
+                stats[t].checksum += execute(x, w.graph, [&](Task c) { stack.push_back(c); });
+                stats[t].tasks++;
+            }
+        }
+    });
+    RunResult r = collect(elapsed, stats);
+    // interior nodes consumed by the breadth-first expansion ran before timing started
+    r.tasks += expanded_nodes;
+    volatile uint64_t sink = pre_checksum; (void)sink;
+    return r;
+}
+
+// 2. Central queue: one std::deque behind one mutex
+RunResult run_central(const Workload &w, size_t n_threads) {
+    std::deque<Task> queue(w.roots.begin(), w.roots.end());
+    std::mutex mu;
+    std::atomic<size_t> pending(w.roots.size());
+    std::vector<WorkerStats> stats(n_threads);
+
+    double elapsed = run_workers(n_threads, [&](size_t t) {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            Task x;
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                if (queue.empty()) continue;
+                x = queue.front(); queue.pop_front();
+            }
+            stats[t].checksum += execute(x, w.graph, [&](Task c) {
+                pending.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(mu);
+                queue.push_back(c);
+            });
+            stats[t].tasks++;
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+    });
+    return collect(elapsed, stats);
+}
+
+// 3. Work stealing: each worker starts with its static chunk (recursive: the
+//    root goes to worker 0), runs LIFO from its own deque and steals FIFO from
+//    a random victim when empty
+RunResult run_stealing(const Workload &w, size_t n_threads) {
+    size_t cap = 1024;
+    while (cap < w.roots.size() / n_threads + n_threads + 2 * FIB_DEPTH + 2) cap *= 2;
+    std::vector<std::unique_ptr<ChaseLevDeque>> deques;
+    for (size_t t = 0; t < n_threads; t++) deques.emplace_back(new ChaseLevDeque(cap));
+    size_t chunk = w.roots.size() / n_threads;
+    for (size_t t = 0; t < n_threads; t++) {
+        size_t start = t * chunk;
+        size_t end = (t == n_threads - 1) ? w.roots.size() : start + chunk;
+        // push in reverse so the owner takes its chunk front to back
+        for (size_t i = end; i > start; i--) deques[t]->push(w.roots[i - 1]);
+    }
+    std::atomic<size_t> pending(w.roots.size());
+    std::vector<WorkerStats> stats(n_threads);
+
+    double elapsed = run_workers(n_threads, [&](size_t t) {
+        std::mt19937 rng(t + 1);
+        ChaseLevDeque &own = *deques[t];
+        while (pending.load(std::memory_order_acquire) > 0) {
+            Task x = own.take();
+            if (x == ChaseLevDeque::EMPTY) {
+                if (n_threads == 1) continue;
+                size_t victim = rng() % (n_threads - 1);
+                if (victim >= t) victim++;
+                stats[t].steal_attempts++;
+                x = deques[victim]->steal();
+                if (x == ChaseLevDeque::EMPTY) { std::this_thread::yield(); continue; }
+                stats[t].steals++;
+            }
+            stats[t].checksum += execute(x, w.graph, [&](Task c) {
+                pending.fetch_add(1, std::memory_order_relaxed);
+                own.push(c);
+            });
+            stats[t].tasks++;
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+    });
+    return collect(elapsed, stats);
+}
+
+// ===================== Noisy Neighbor =====================
+// Spins on the first allowed CPU for the whole run, so worker 0, which is
+// pinned there too, gets roughly half a core
+class NoiseThread {
+    std::atomic<bool> stop{false};
+    std::thread th;
+public:
+    explicit NoiseThread(bool enabled) {
+        if (enabled) th = std::thread([this] {
+            pin_to_cpu(0);
+            volatile uint64_t sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) sink = sink + spin(1000);
+        });
+    }
+    ~NoiseThread() { stop = true; if (th.joinable()) th.join(); }
+};
+
+// ===================== CSV Output Helper =====================
+void write_csv(std::ofstream &file, const std::string &graph, const std::string &sched,
+               size_t threads, bool noise, const RunResult &r) {
+    file << graph << "," << sched << "," << threads << "," << noise << ","
+         << r.makespan_s << "," << r.tasks << "," << r.steals << "," << r.steal_attempts << "\n";
+}
+
+// ===================== Main Benchmark =====================
+int main() {
+    std::filesystem::create_directory("results");
+    std::ofstream file("results/work_stealing.csv");
+    file << "Graph,Scheduler,Threads,Noise,Makespan_s,Tasks,Steals,StealAttempts\n";
+
+    std::vector<size_t> thread_counts;
+    size_t n_cpus = std::max<size_t>(1, allowed_cpus().size()); // CPUs we may pin to
+    for (size_t t = 1; t < n_cpus; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(n_cpus);
+
+    std::vector<std::pair<Graph, std::string>> graphs = {
+        {Graph::Uniform, "Uniform"}, {Graph::Skewed, "Skewed"}, {Graph::Recursive, "Recursive"}};
+    std::vector<std::pair<RunResult (*)(const Workload &, size_t), std::string>> schedulers = {
+        {run_static, "Static"}, {run_central, "CentralQueue"}, {run_stealing, "WorkStealing"}};
+
+    for (auto &[graph, graph_str] : graphs) {
+        Workload w = make_workload(graph);
+        for (bool noise : {false, true}) {
+            for (auto n_threads : thread_counts) {
+                for (auto &[sched, sched_str] : schedulers) {
+                    NoiseThread nt(noise);
+                    RunResult r = sched(w, n_threads);
+                    if (r.tasks != w.total_tasks)
+                        std::cerr << "⚠️ " << sched_str << " ran " << r.tasks << " of "
+                                  << w.total_tasks << " tasks\n";
+
+                    std::cout << "Graph: " << graph_str
+                              << " | Scheduler: " << sched_str
+                              << " | Threads: " << n_threads
+                              << " | Noise: " << noise
+                              << " | Makespan: " << r.makespan_s << " s"
+                              << " | Steals: " << r.steals << "/" << r.steal_attempts
+                              << std::endl;
+                    write_csv(file, graph_str, sched_str, n_threads, noise, r);
+                }
+            }
+        }
+    }
+    std::cout << "✅ Results saved to results/work_stealing.csv\n";
+}